@@ -93,17 +93,11 @@ ScoreType CombatSimulation::simulateCombat()
 {
     try
     {
-	    SparCraft::GameState s1(state);
+	    SparCraft::ScriptPlayout playout(state, SparCraft::PlayerModels::NOKDPS, SparCraft::PlayerModels::NOKDPS, 2000);
 
-        SparCraft::PlayerPtr selfNOK(new SparCraft::Player_NOKDPS(getSparCraftPlayerID(BWAPI::Broodwar->self())));
-
-	    SparCraft::PlayerPtr enemyNOK(new SparCraft::Player_NOKDPS(getSparCraftPlayerID(BWAPI::Broodwar->enemy())));
-
-	    SparCraft::Game g (s1, selfNOK, enemyNOK, 2000);
-
-	    g.play();
+	    playout.play();
 	
-	    ScoreType eval =  g.getState().eval(SparCraft::Players::Player_One, SparCraft::EvaluationMethods::LTD2).val();
+	    ScoreType eval =  playout.getState().eval(SparCraft::Players::Player_One, SparCraft::EvaluationMethods::LTD2).val();
 
 	    BWAPI::Broodwar->drawTextScreen(240, 280, "Combat Sim : %d", eval);
         
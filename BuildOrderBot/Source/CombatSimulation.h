@@ -11,6 +11,7 @@
 #include "..\..\SparCraft\source\Game.h"
 #include "..\..\SparCraft\source\Unit.h"
 #include "..\..\SparCraft\source\AllPlayers.h"
+#include "..\..\SparCraft\source\ScriptPlayout.h"
 
 class CombatSimulation
 {
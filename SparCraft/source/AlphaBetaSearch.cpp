@@ -1,11 +1,44 @@
 #include "AlphaBetaSearch.h"
 
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+
 using namespace SparCraft;
 
+namespace
+{
+	// what an action does relative to its unit, the last part of a history table key
+	enum { Target_None, Attack_Kill, Attack_Threat, Attack_Other, Move_Toward, Move_Side, Move_Away, Num_Targets };
+
+	enum { Num_Type_IDs = 256, Num_Action_Types = UnitActionTypes::HEAL + 1 };
+
+	const size_t History_Size = Constants::Num_Players * Num_Type_IDs * Num_Action_Types * Num_Targets;
+
+	// the bounds of a full window
+	const ScoreType Score_Min = -10000000;
+	const ScoreType Score_Max =  10000000;
+
+	// the scores next to a score, which are ordered by value and then by fewer moves, so a window
+	// between a score and one of these has no score inside it
+	const StateEvalScore scoreAbove(const StateEvalScore & score)
+	{
+		return StateEvalScore(score.val(), score.numMoves() - 1);
+	}
+
+	const StateEvalScore scoreBelow(const StateEvalScore & score)
+	{
+		return StateEvalScore(score.val(), score.numMoves() + 1);
+	}
+}
+
 AlphaBetaSearch::AlphaBetaSearch(const AlphaBetaSearchParameters & params, TTPtr TT) 
 	: _params(params)
 	, _currentRootDepth(0)
-	, _TT(TT ? TT : TTPtr(new TranspositionTable()))
+	, _TT(TT ? TT : TTPtr(new TranspositionTable(params.transpositionTableMB())))
+	, _bestSoFarDepth(0)
+	, _helper(0)
+	, _random(NULL)
+	, _parentDeadline(NULL)
 {
     for (size_t p(0); p<Constants::Num_Players; ++p)
     {
@@ -21,24 +54,70 @@ AlphaBetaSearch::AlphaBetaSearch(const AlphaBetaSearchParameters & params, TTPtr
             _playerModels[p] = AllPlayers::getPlayerPtr(p, _params.playerModel(p));
         }
     }
+
+	if (_params.historyHeuristic())
+	{
+		_history.resize(History_Size);
+	}
 }
 
 void AlphaBetaSearch::doSearch(GameState & initialState)
 {
 	_searchTimer.start();
+	_deadline.start((double)_params.timeLimit(), _parentDeadline);
+
+	{
+		boost::mutex::scoped_lock lock(_bestSoFarMutex);
+		_bestSoFar.clear();
+		_bestSoFarDepth = 0;
+	}
+
+	// a persistent table keeps the entries of the earlier searches, whose moves are still searched first
+	// when their states come up again but which are replaced first, otherwise every search starts from
+	// an empty one. The helpers of a Lazy SMP search are part of the main thread's search
+	if (_helper == 0)
+	{
+		if (_params.persistentTT())
+		{
+			_TT->newSearch();
+		}
+		else
+		{
+			_TT->clear();
+		}
+	}
+
+	_results.ttLookups = 0;
+	_results.ttFound = 0;
+	_results.cutoffs = 0;
+	_results.firstMoveCutoffs = 0;
+	_results.aspirationResearches = 0;
+	_results.pvsResearches = 0;
 
-	StateEvalScore alpha(-10000000, 1000000);
-	StateEvalScore beta	( 10000000, 1000000);
+	// the history and killers are learned anew in every search
+	std::fill(_history.begin(), _history.end(), 0);
+
+	for (size_t ply(0); ply < Constants::Max_Search_Depth; ++ply)
+	{
+		for (size_t k(0); k < Num_Killers; ++k)
+		{
+			_killers[ply][k].clear();
+		}
+	}
+
+	StateEvalScore alpha(Score_Min, 1000000);
+	StateEvalScore beta	(Score_Max, 1000000);
 
 	AlphaBetaValue val;
 
 	if (_params.searchMethod() == SearchMethods::AlphaBeta)
 	{
+		_currentRootDepth = _params.maxDepth();
 		val = alphaBeta(initialState, _params.maxDepth(), Players::Player_None, NULL, alpha, beta);
 	}
 	else if (_params.searchMethod() == SearchMethods::IDAlphaBeta)
 	{
-		val = IDAlphaBeta(initialState, _params.maxDepth());
+		val = (_params.numThreads() > 1) ? lazySMPSearch(initialState) : IDAlphaBeta(initialState, _params.maxDepth());
 	}
 
 	_results.timeElapsed = _searchTimer.getElapsedTimeInMilliSec();
@@ -50,28 +129,59 @@ AlphaBetaValue AlphaBetaSearch::IDAlphaBeta(GameState & initialState, const size
 	_results.nodesExpanded = 0;
 	_results.maxDepthReached = 0;
 
-	for (size_t d(1); d < maxDepth; ++d)
+	bool scored(false);
+
+	// every other helper starts a depth deeper so the threads aren't all on the same iteration
+	for (size_t d(1 + (_helper % 2)); d < maxDepth; ++d)
 	{
 		
-		StateEvalScore alpha(-10000000, 999999);
-		StateEvalScore beta	( 10000000, 999999);
+		StateEvalScore alpha(Score_Min, 999999);
+		StateEvalScore beta	(Score_Max, 999999);
+
+		// the score seldom moves far from one iteration to the next, so a window around the last one
+		// gets more cuts
+		if (scored && (_params.aspirationWindow() > 0))
+		{
+			alpha = StateEvalScore(std::max(val.score().val() - _params.aspirationWindow(), Score_Min), 999999);
+			beta  = StateEvalScore(std::min(val.score().val() + _params.aspirationWindow(), Score_Max), 999999);
+		}
 		
 		_results.maxDepthReached = d;
 		_currentRootDepth = d;
 
 		// perform ID-AB until time-out
-		try
+		AlphaBetaValue iteration;
+
+		while (true)
 		{
-			val = alphaBeta(initialState, d, Players::Player_None, NULL, alpha, beta);
+			iteration = alphaBeta(initialState, d, Players::Player_None, NULL, alpha, beta);
+
+			if (_deadline.isCancelled())
+			{
+				break;
+			}
 
-			_results.bestMoves = val.abMove().moveVec();
-			_results.abValue = val.score().val();
+			// a score on the edge of the window only bounds the real one, so that side of the window is
+			// opened up and the iteration searched again
+			if (!(iteration.score() > alpha) && (alpha.val() > Score_Min))
+			{
+				alpha = StateEvalScore(Score_Min, 999999);
+			}
+			else if (!(iteration.score() < beta) && (beta.val() < Score_Max))
+			{
+				beta = StateEvalScore(Score_Max, 999999);
+			}
+			else
+			{
+				break;
+			}
+
+			_results.aspirationResearches++;
 		}
-		// if we do time-out
-		catch (int e)
-		{
-			e += 1;
 
+		// if we do time-out the iteration wasn't finished, so its value is thrown out
+		if (_deadline.isCancelled())
+		{
 			// if we didn't finish the first depth, set the move to the best script move
 			if (d == 1)
 			{
@@ -85,31 +195,77 @@ AlphaBetaValue AlphaBetaSearch::IDAlphaBeta(GameState & initialState, const size
 			break;
 		}
 
+		val = iteration;
+		scored = true;
+		_results.bestMoves = val.abMove().moveVec();
+		_results.abValue = val.score().val();
+
+		{
+			boost::mutex::scoped_lock lock(_bestSoFarMutex);
+			_bestSoFar = _results.bestMoves;
+			_bestSoFarDepth = d;
+		}
+
 		long long unsigned nodes = _results.nodesExpanded;
 		double ms = _searchTimer.getElapsedTimeInMilliSec();
 
 		//printTTResults();
-		//fprintf(stdout, "%s %8d %9d %9d %13.4lf %14llu %12d %12llu %15.2lf\n", "IDA", d, val.score().val(), (int)val.abMove().moveTuple(), ms, nodes, (int)_TT->numFound(), getResults().ttcuts, 1000*nodes/ms);
+		//fprintf(stdout, "%s %8d %9d %9d %13.4lf %14llu %12d %12llu %15.2lf\n", "IDA", d, val.score().val(), (int)val.abMove().moveTuple(), ms, nodes, (int)_results.ttFound, getResults().ttcuts, 1000*nodes/ms);
 	}
 
 	return val;
 }
 
-// Transposition Table save 
-void AlphaBetaSearch::TTsave(	GameState & state, const StateEvalScore & value, const StateEvalScore & alpha, const StateEvalScore & beta, const size_t & depth, 
-						const IDType & firstPlayer, const AlphaBetaMove & bestFirstMove, const AlphaBetaMove & bestSecondMove) 
+// Lazy SMP: helper threads run the same iterative deepening search from the root, each with the
+// moves shuffled by a generator of its own and the scripts tried in a different order, so they get
+// to different parts of the tree first. They share the transposition table with this search, which
+// then cuts with the entries they left. Only the result of this thread is used, the helpers are
+// stopped as soon as it is done
+AlphaBetaValue AlphaBetaSearch::lazySMPSearch(GameState & initialState)
 {
-	// IF THE DEPTH OF THE ENTRY IS BIGGER THAN CURRENT DEPTH, DO NOTHING
-	TTEntry * entry = _TT->lookupScan(state.calculateHash(0), state.calculateHash(1));
-	bool valid = entry && entry->isValid();
-	size_t edepth = entry ? entry->getDepth() : 0;
+	AlphaBetaSearchParameters params(_params);
+	params.setNumThreads(1);
 
-	_results.ttSaveAttempts++;
-	
-	if (valid && (edepth > depth)) 
+	std::vector< boost::shared_ptr<AlphaBetaSearch> >   helpers;
+	std::vector<GameState>                              states(_params.numThreads() - 1, initialState);
+	boost::thread_group                                 threads;
+
+	_results.helperNodesExpanded = 0;
+	_results.helperMaxDepth = 0;
+
+	for (size_t t(0); t < states.size(); ++t)
 	{
-		return;
+		helpers.push_back(boost::shared_ptr<AlphaBetaSearch>(new AlphaBetaSearch(params, _TT)));
+		helpers[t]->_helper = t + 1;
+		helpers[t]->_parentDeadline = &_deadline;
+		helpers[t]->_gen.seed(rand());
+		helpers[t]->_random = &helpers[t]->_gen;
+	}
+
+	for (size_t t(0); t < helpers.size(); ++t)
+	{
+		threads.create_thread(boost::bind(&AlphaBetaSearch::doSearch, helpers[t].get(), boost::ref(states[t])));
+	}
+
+	AlphaBetaValue val(IDAlphaBeta(initialState, _params.maxDepth()));
+
+	_deadline.cancel();
+	threads.join_all();
+
+	for (size_t t(0); t < helpers.size(); ++t)
+	{
+		_results.helperNodesExpanded += helpers[t]->getResults().nodesExpanded;
+		_results.helperMaxDepth = std::max(_results.helperMaxDepth, helpers[t]->getResults().maxDepthReached);
 	}
+
+	return val;
+}
+
+// Transposition Table save 
+void AlphaBetaSearch::TTsave(	GameState & state, const StateEvalScore & value, const StateEvalScore & alpha, const StateEvalScore & beta, const size_t & depth, 
+						const IDType & playerToMove, const AlphaBetaMove & bestMove) 
+{
+	_results.ttSaveAttempts++;
 	
 	int type(TTEntry::NONE);
 
@@ -117,28 +273,41 @@ void AlphaBetaSearch::TTsave(	GameState & state, const StateEvalScore & value, c
 	else if (value >= beta)  type = TTEntry::LOWER;
 	else                     type = TTEntry::ACCURATE;
 
-	// SAVE A NEW ENTRY IN THE TRANSPOSITION TABLE
-	_TT->save(state.calculateHash(0), state.calculateHash(1), value, depth, type, firstPlayer, bestFirstMove, bestSecondMove);
+	// SAVE A NEW ENTRY IN THE TRANSPOSITION TABLE, UNLESS IT HAS A DEEPER ONE OF THIS STATE
+	const int saved(_TT->save(state.calculateHash(0), state.calculateHash(1), value, depth, type, playerToMove, bestMove));
+
+	if (saved != TranspositionTable::Save_Skipped)
+	{
+		_results.ttSaves++;
+		_results.ttSaveEmpty += (saved == TranspositionTable::Save_Empty) ? 1 : 0;
+		_results.ttSaveSelf  += (saved == TranspositionTable::Save_Self)  ? 1 : 0;
+		_results.ttSaveOther += (saved == TranspositionTable::Save_Other) ? 1 : 0;
+	}
 }
 
 // Transposition Table look up + alpha/beta update
 TTLookupValue AlphaBetaSearch::TTlookup(const GameState & state, StateEvalScore & alpha, StateEvalScore & beta, const size_t & depth)
 {
-	TTEntry * entry = _TT->lookupScan(state.calculateHash(0), state.calculateHash(1));
-	if (entry && (entry->getDepth() == depth)) 
+	TTEntry entry;
+	const bool found(_TT->lookup(state.calculateHash(0), state.calculateHash(1), entry));
+
+	_results.ttLookups++;
+	_results.ttFound += found ? 1 : 0;
+
+	if (found && (entry.getDepth() == depth)) 
 	{
 		// get the value and type of the entry
-		StateEvalScore TTvalue = entry->getScore();
+		StateEvalScore TTvalue = entry.getScore();
 		
 		// set alpha and beta depending on the type of entry in the TT
-		if (entry->getType() == TTEntry::LOWER)
+		if (entry.getType() == TTEntry::LOWER)
 		{
 			if (TTvalue > alpha) 
 			{
 				alpha = TTvalue;
 			}
 		}
-		else if (entry->getType() == TTEntry::UPPER) 
+		else if (entry.getType() == TTEntry::UPPER) 
 		{
 			if (TTvalue < beta)
 			{
@@ -165,7 +334,7 @@ TTLookupValue AlphaBetaSearch::TTlookup(const GameState & state, StateEvalScore
 			return TTLookupValue(true, false, entry);
 		}
 	}
-	else if (entry)
+	else if (found)
 	{
 		_results.ttFoundLessDepth++;
 		return TTLookupValue(true, false, entry);
@@ -174,9 +343,14 @@ TTLookupValue AlphaBetaSearch::TTlookup(const GameState & state, StateEvalScore
 	return TTLookupValue(false, false, entry);
 }
 
+void AlphaBetaSearch::setTranspositionTable(TTPtr TT)
+{
+	_TT = TT ? TT : TTPtr(new TranspositionTable(_params.transpositionTableMB()));
+}
+
 const bool AlphaBetaSearch::searchTimeOut()
 {
-	return (_params.timeLimit() && (_results.nodesExpanded % 50 == 0) && (_searchTimer.getElapsedTimeInMilliSec() >= _params.timeLimit()));
+	return _deadline.expired();
 }
 
 const bool AlphaBetaSearch::terminalState(GameState & state, const size_t & depth) const
@@ -184,20 +358,17 @@ const bool AlphaBetaSearch::terminalState(GameState & state, const size_t & dept
 	return (depth <= 0 || state.isTerminal());
 }
 
-const AlphaBetaMove & AlphaBetaSearch::getAlphaBetaMove(const TTLookupValue & TTval, const IDType & playerToMove) const
+// the best move stored for this state, invalid if it was the other player's or isn't in the moves
+const AlphaBetaMove AlphaBetaSearch::getAlphaBetaMove(const TTLookupValue & TTval, const MoveArray & moves, const IDType & playerToMove) const
 {
-	const IDType enemyPlayer(getEnemy(playerToMove));
+	std::vector<UnitAction> moveVec;
 
-	// if we have a valid first move for this player, use it
-	if (TTval.entry()->getBestMove(playerToMove).firstMove().isValid())
+	if (TTval.found() && TTval.entry().getBestMove(playerToMove, moves, moveVec))
 	{
-		return TTval.entry()->getBestMove(playerToMove).firstMove();
-	}
-	// otherwise return the response to an opponent move, if it doesn't exist it will just be invalid
-	else
-	{
-		return TTval.entry()->getBestMove(enemyPlayer).secondMove();
+		return AlphaBetaMove(moveVec, true);
 	}
+
+	return AlphaBetaMove();
 }
 
 void AlphaBetaSearch::generateOrderedMoves(GameState & state, MoveArray & moves, const TTLookupValue & TTval, const IDType & playerToMove, const size_t & depth)
@@ -214,33 +385,32 @@ void AlphaBetaSearch::generateOrderedMoves(GameState & state, MoveArray & moves,
 
         // generate the moves into that vector
         _playerModels[playerToMove]->getMoves(state, moves, orderedMoves[0]);
+		_killerIndex[depth] = orderedMoves.size();
+		_hasTTMove[depth] = false;
 		
 		return;
 	}
 
-	// if there is a transposition table entry for this state
-	/*if (TTval.found())
+	// if there is a transposition table entry for this state, its best move is searched first
+	if (TTval.found())
 	{
-		// get the abMove we stored for this player
-		const AlphaBetaMove & abMove = getAlphaBetaMove(TTval, playerToMove);
+		const AlphaBetaMove abMove(getAlphaBetaMove(TTval, moves, playerToMove));
 
 		_results.ttFoundCheck++;
 
-		// Two checks:
-		// 1) Is the move 'valid' ie: was it actually set inside the TT
-		// TODO:: Possibly validate this move a second time somehow
-        //        Was previously done with move tuple numbers
 		if (abMove.isValid())
 		{
 			orderedMoves.add(abMove.moveVec());
 			_results.ttMoveOrders++;
-			return;
 		}
 		else
 		{
 			_results.ttFoundButNoMove++;
 		}
-	}*/
+	}
+
+	const size_t numTTMoves(orderedMoves.size());
+	_hasTTMove[depth] = (numTTMoves > 0);
 
     if (depth == 2)
     {
@@ -250,11 +420,19 @@ void AlphaBetaSearch::generateOrderedMoves(GameState & state, MoveArray & moves,
     // if we are using script move ordering, insert the script moves we want
     if (_params.moveOrderingMethod() == MoveOrderMethod::ScriptFirst)
     {
-        for (size_t s(0); s<_params.getOrderedMoveScripts().size(); s++)
+        const size_t numScripts(_params.getOrderedMoveScripts().size());
+
+        // the helpers of a Lazy SMP search each start from a different script
+        for (size_t s(0); s<numScripts; s++)
 	    {
             std::vector<UnitAction> moveVec;
-		    _allScripts[playerToMove][s]->getMoves(state, moves, moveVec);
-		    orderedMoves.add(moveVec);
+		    _allScripts[playerToMove][(s + _helper) % numScripts]->getMoves(state, moves, moveVec);
+
+		    // the script may give the table's move, which is already first
+		    if ((numTTMoves == 0) || (moveVec != orderedMoves[0]))
+		    {
+			    orderedMoves.add(moveVec);
+		    }
 	    }
 
         if (orderedMoves.size() < 2)
@@ -262,6 +440,155 @@ void AlphaBetaSearch::generateOrderedMoves(GameState & state, MoveArray & moves,
             int a = 6;
         }
     }
+
+	// then the tuples which last caused a cut at this ply, if this node has the same moves
+	_killerIndex[depth] = orderedMoves.size();
+
+	if (_params.killerMoves())
+	{
+		const size_t ply(_currentRootDepth - depth);
+
+		for (size_t k(0); k < Num_Killers; ++k)
+		{
+			const std::vector<UnitAction> & killer(_killers[ply][k]);
+
+			if (!killer.empty() && !orderedMoves.containsSize(killer) && isLegalMoveVec(moves, killer))
+			{
+				orderedMoves.add(killer);
+			}
+		}
+	}
+}
+
+// true if the tuple has one of its generated moves for each unit which can move
+const bool AlphaBetaSearch::isLegalMoveVec(const MoveArray & moves, const std::vector<UnitAction> & moveVec) const
+{
+	if (moveVec.size() != moves.numUnits())
+	{
+		return false;
+	}
+
+	for (size_t u(0); u < moves.numUnits(); ++u)
+	{
+		bool found(false);
+
+		for (size_t m(0); !found && m < moves.numMoves(u); ++m)
+		{
+			found = moves.getMove(u, m) == moveVec[u];
+		}
+
+		if (!found)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// the mean position of the enemy's units, which MOVE actions are keyed by in the history table
+const Position AlphaBetaSearch::getEnemyCenter(const GameState & state, const IDType & player) const
+{
+	const IDType        enemy(getEnemy(player));
+	const UnitArrays &  arrays(state.getUnitArrays());
+	const size_t        numEnemies(state.numUnits(enemy));
+
+	if (numEnemies == 0)
+	{
+		return Position(0, 0);
+	}
+
+	long long x(0), y(0);
+
+	for (size_t u(0); u < numEnemies; ++u)
+	{
+		x += arrays.x(enemy, u);
+		y += arrays.y(enemy, u);
+	}
+
+	return Position((PositionType)(x / (long long)numEnemies), (PositionType)(y / (long long)numEnemies));
+}
+
+// An attack is keyed by whether it kills its target, and otherwise by whether the target can shoot
+// back. A move is keyed by whether it goes toward the center of the enemy units, away from it or
+// neither. Other actions have no target
+const size_t AlphaBetaSearch::getHistoryIndex(GameState & state, const UnitAction & move, const Position & enemyCenter) const
+{
+	const Unit &    unit(state.getUnit(move.player(), move.unit()));
+	int             target(Target_None);
+
+	if (move.type() == UnitActionTypes::ATTACK)
+	{
+		const Unit & enemyUnit(state.getUnit(getEnemy(move.player()), move.index()));
+
+		if (unit.getDamageTo(enemyUnit) >= enemyUnit.currentHP())
+		{
+			target = Attack_Kill;
+		}
+		else
+		{
+			target = enemyUnit.canAttackTarget(unit, state.getTime()) ? Attack_Threat : Attack_Other;
+		}
+	}
+	else if (move.type() == UnitActionTypes::MOVE)
+	{
+		const Position  from(unit.currentPosition(state.getTime()));
+		const long long toward(	(long long)(move.pos().x() - from.x()) * (enemyCenter.x() - from.x())
+							  + (long long)(move.pos().y() - from.y()) * (enemyCenter.y() - from.y()));
+
+		target = toward > 0 ? Move_Toward : (toward < 0 ? Move_Away : Move_Side);
+	}
+
+	return ((move.player() * Num_Type_IDs + unit.typeID()) * Num_Action_Types + move.type()) * Num_Targets + target;
+}
+
+// sorts the actions of each unit by their history scores, so the tuples enumerated first combine
+// the actions which caused the most cuts
+void AlphaBetaSearch::orderMovesByHistory(GameState & state, MoveArray & moves, const IDType & playerToMove) const
+{
+	const Position  enemyCenter(getEnemyCenter(state, playerToMove));
+	int             scores[Constants::Max_Moves];
+
+	for (size_t u(0); u < moves.numUnits(); ++u)
+	{
+		for (size_t m(0); m < moves.numMoves(u); ++m)
+		{
+			scores[m] = _history[getHistoryIndex(state, moves.getMove(u, m), enemyCenter)];
+		}
+
+		moves.sortMoves(u, scores);
+	}
+}
+
+// A tuple caused a cut, so its actions get a bonus of depth squared and it becomes a killer. The
+// tuple of a script isn't kept as a killer, since the script most likely gives it at the other
+// nodes of the ply as well, and neither is the table's, which was the best of this state only
+void AlphaBetaSearch::updateMoveHistory(GameState & state, const std::vector<UnitAction> & moveVec, const IDType & playerToMove, const size_t & depth, const size_t & moveNumber)
+{
+	if (_params.historyHeuristic())
+	{
+		const Position enemyCenter(getEnemyCenter(state, playerToMove));
+
+		for (size_t a(0); a < moveVec.size(); ++a)
+		{
+			_history[getHistoryIndex(state, moveVec[a], enemyCenter)] += (int)(depth * depth);
+		}
+	}
+
+	if (_params.killerMoves() && (moveNumber >= _killerIndex[depth]))
+	{
+		Array<std::vector<UnitAction>, Num_Killers> & killers(_killers[_currentRootDepth - depth]);
+
+		if (killers[0] != moveVec)
+		{
+			for (size_t k(Num_Killers - 1); k > 0; --k)
+			{
+				killers[k] = killers[k - 1];
+			}
+
+			killers[0] = moveVec;
+		}
+	}
 }
 
 bool AlphaBetaSearch::getNextMoveVec(IDType playerToMove, MoveArray & moves, const size_t & moveNumber, const TTLookupValue & TTval, const size_t & depth, std::vector<UnitAction> & moveVec) const
@@ -280,18 +607,6 @@ bool AlphaBetaSearch::getNextMoveVec(IDType playerToMove, MoveArray & moves, con
             // so return false
 		    return false;
 	    }
-
-	    // if there is a transposition table entry for this state
-	    if (TTval.found())
-	    {
-		    // if there was a valid move found with higher depth, just do that one
-		    const AlphaBetaMove & abMove = getAlphaBetaMove(TTval, playerToMove);
-		    if ((TTval.entry()->getDepth() >= depth) && abMove.isValid())
-		    {
-                // so return false
-			    return false;
-		    }
-	    }
     }
 
 	const Array<std::vector<UnitAction>, Constants::Max_Ordered_Moves> & orderedMoves(_orderedMoves[depth]);
@@ -303,18 +618,21 @@ bool AlphaBetaSearch::getNextMoveVec(IDType playerToMove, MoveArray & moves, con
         moveVec.assign(orderedMoves[moveNumber].begin(), orderedMoves[moveNumber].end());
         return true;
 	}
-	// otherwise return the next move vector starting from the beginning
+	// otherwise return the next move vector starting from the beginning, but the table's move was
+	// searched first so it is skipped
 	else
 	{
-        if (moves.hasMoreMoves())
+        while (moves.hasMoreMoves())
         {
             moves.getNextMoveVec(moveVec);
-            return true;
-        }
-        else
-        {
-            return false;
+
+            if (!_hasTTMove[depth] || (moveVec != orderedMoves[0]))
+            {
+                return true;
+            }
         }
+
+        return false;
 	}
 }
 
@@ -369,9 +687,10 @@ AlphaBetaValue AlphaBetaSearch::alphaBeta(GameState & state, size_t depth, const
 	// update statistics
 	_results.nodesExpanded++;
 
+	// the value is thrown out by the caller
 	if (searchTimeOut())
 	{
-		throw 1;
+		return AlphaBetaValue();
 	}
     
 	if (terminalState(state, depth))
@@ -388,16 +707,16 @@ AlphaBetaValue AlphaBetaSearch::alphaBeta(GameState & state, size_t depth, const
 	// is the player to move the max player?
 	bool maxPlayer = (playerToMove == _params.maxPlayer());
 
-	// Transposition Table Logic
+	// Transposition Table Logic, the root isn't looked up since its move has to come from the search
 	TTLookupValue TTval;
-	if (isTranspositionLookupState(state, prevSimMove))
+	if (isTranspositionLookupState(state, prevSimMove) && !isRoot(depth))
 	{
 		TTval = TTlookup(state, alpha, beta, depth);
 
-		// if this is a TT cut, return the proper value
+		// if this is a TT cut, return the proper value, only the root's move is used
 		if (TTval.cut())
 		{
-			return AlphaBetaValue(TTval.entry()->getScore(), getAlphaBetaMove(TTval, playerToMove));
+			return AlphaBetaValue(TTval.entry().getScore(), AlphaBetaMove());
 		}
 	}
 
@@ -406,23 +725,41 @@ AlphaBetaValue AlphaBetaSearch::alphaBeta(GameState & state, size_t depth, const
 	// move generation
 	MoveArray & moves = _allMoves[depth];
 	state.generateMoves(moves, playerToMove);
-    moves.shuffleMoveActions();
+    moves.shuffleMoveActions(_random);
 	generateOrderedMoves(state, moves, TTval, playerToMove, depth);
 
 	// while we have more simultaneous moves
-	AlphaBetaMove bestMove, bestSimResponse;
+	AlphaBetaMove bestMove;
 	    
     size_t moveNumber(0);
     std::vector<UnitAction> moveVec;
+	const bool historyOrdering(_params.historyHeuristic() && _params.playerModel(playerToMove) == PlayerModels::None);
 
     // for each child
-    while (getNextMoveVec(playerToMove, moves, moveNumber, TTval, depth, moveVec))
+    while (true)
 	{
+		// the history only orders the tuples enumerated after the scripts and killers, which most
+		// nodes have cut before they get to
+		if (historyOrdering && (moveNumber == _orderedMoves[depth].size()))
+		{
+			orderMovesByHistory(state, moves, playerToMove);
+		}
+
+		if (!getNextMoveVec(playerToMove, moves, moveNumber, TTval, depth, moveVec))
+		{
+			break;
+		}
+
         // the value of the recursive AB we will call
 		AlphaBetaValue val;
-		
-		// generate the child state
-		GameState child(state);
+
+		// PVS, the children after the first only have to be shown no better than the best so far,
+		// which a null window does with fewer nodes, and the few which are better are searched again.
+		// Both nodes of a simultaneous move state are max or min nodes like the others, so it works
+		// the same way whichever of them this is
+		const bool nullWindow(_params.principalVariation() && (moveNumber > 0) && (scoreAbove(alpha) < beta));
+		const StateEvalScore childAlpha((nullWindow && !maxPlayer) ? scoreBelow(beta) : alpha);
+		const StateEvalScore childBeta ((nullWindow && maxPlayer)  ? scoreAbove(alpha) : beta);
 
 		bool firstMove = true;
 
@@ -431,12 +768,20 @@ AlphaBetaValue AlphaBetaSearch::alphaBeta(GameState & state, size_t depth, const
 		{
 			firstMove = true;
 			// don't generate a child yet, just pass on the move we are investigating
-			val = alphaBeta(state, depth-1, playerToMove, &moveVec, alpha, beta);
+			val = alphaBeta(state, depth-1, playerToMove, &moveVec, childAlpha, childBeta);
+
+			if (nullWindow && nullWindowFailed(val, alpha, beta))
+			{
+				val = alphaBeta(state, depth-1, playerToMove, &moveVec, alpha, beta);
+			}
 		}
 		else
 		{
 			firstMove = false;
 
+			// generate the child state, the first player of a simultaneous move state doesn't need one
+			GameState child(state);
+
 			// if this is the 2nd move of a simultaneous move state
 			if (prevSimMove)
 			{
@@ -449,7 +794,18 @@ AlphaBetaValue AlphaBetaSearch::alphaBeta(GameState & state, size_t depth, const
 			child.finishedMoving();
 
 			// get the alpha beta value
-			val = alphaBeta(child, depth-1, playerToMove, NULL, alpha, beta);
+			val = alphaBeta(child, depth-1, playerToMove, NULL, childAlpha, childBeta);
+
+			if (nullWindow && nullWindowFailed(val, alpha, beta))
+			{
+				val = alphaBeta(child, depth-1, playerToMove, NULL, alpha, beta);
+			}
+		}
+
+		// if the search ran out of time below here the value of this node can't be used or saved either
+		if (_deadline.isCancelled())
+		{
+			return AlphaBetaValue();
 		}
 
 		// set alpha or beta based on maxplayer
@@ -459,11 +815,6 @@ AlphaBetaValue AlphaBetaSearch::alphaBeta(GameState & state, size_t depth, const
 			bestMove = AlphaBetaMove(moveVec, true);
 			bestMoveSet = true;
 
-			if (state.bothCanMove() && !prevSimMove)
-			{
-				bestSimResponse = val.abMove();
-			}
-
 			// if this is depth 1 of the first try at depth 1, store the best in results
 		}
 		else if (!maxPlayer && (val.score() < beta))
@@ -471,14 +822,9 @@ AlphaBetaValue AlphaBetaSearch::alphaBeta(GameState & state, size_t depth, const
 			beta = val.score();
 			bestMove = AlphaBetaMove(moveVec, true);
 			bestMoveSet = true;
-
-			if (state.bothCanMove() && prevSimMove)
-			{
-				bestSimResponse = val.abMove();
-			}
 		}
 
-		if (alpha.val() == -10000000 && beta.val() == 10000000)
+		if (alpha.val() == Score_Min && beta.val() == Score_Max)
 		{
 			fprintf(stderr, "\n\nALPHA BETA ERROR, NO VALUE SET\n\n");
 		}
@@ -486,6 +832,9 @@ AlphaBetaValue AlphaBetaSearch::alphaBeta(GameState & state, size_t depth, const
 		// alpha-beta cut
 		if (alpha >= beta) 
 		{ 
+			_results.cutoffs++;
+			_results.firstMoveCutoffs += (moveNumber == 0) ? 1 : 0;
+			updateMoveHistory(state, moveVec, playerToMove, depth, moveNumber);
 			break; 
 		}
 
@@ -494,7 +843,7 @@ AlphaBetaValue AlphaBetaSearch::alphaBeta(GameState & state, size_t depth, const
 	
 	if (isTranspositionLookupState(state, prevSimMove))
 	{
-		TTsave(state, maxPlayer ? alpha : beta, alpha, beta, depth, playerToMove, bestMove, bestSimResponse);
+		TTsave(state, maxPlayer ? alpha : beta, alpha, beta, depth, playerToMove, bestMove);
 	}
 
 	return maxPlayer ? AlphaBetaValue(alpha, bestMove) : AlphaBetaValue(beta, bestMove);
@@ -506,11 +855,37 @@ AlphaBetaSearchResults & AlphaBetaSearch::getResults()
 	return _results;
 }
 
+void AlphaBetaSearch::cancel()
+{
+	_deadline.cancel();
+}
+
+const size_t AlphaBetaSearch::getBestMovesSoFar(std::vector<UnitAction> & moveVec) const
+{
+	boost::mutex::scoped_lock lock(_bestSoFarMutex);
+	moveVec = _bestSoFar;
+
+	return _bestSoFarDepth;
+}
+
 const IDType AlphaBetaSearch::getEnemy(const IDType & player) const
 {
 	return (player + 1) % 2;
 }
 
+// a child searched with a null window beat it if its score is inside the real window, which it then
+// has to be searched with to get the score
+const bool AlphaBetaSearch::nullWindowFailed(const AlphaBetaValue & val, const StateEvalScore & alpha, const StateEvalScore & beta)
+{
+	if (_deadline.isCancelled() || !(val.score() > alpha) || !(val.score() < beta))
+	{
+		return false;
+	}
+
+	_results.pvsResearches++;
+	return true;
+}
+
 const bool AlphaBetaSearch::isRoot(const size_t & depth) const
 {
 	return depth == _currentRootDepth;
@@ -519,16 +894,16 @@ const bool AlphaBetaSearch::isRoot(const size_t & depth) const
 void AlphaBetaSearch::printTTResults() const
 {
 	printf("\n");
+	printf("Size                   %9d\n", (int)_TT->getSize());
 	printf("Total Usage            %9d\n", (int)_TT->getUsage());
 	printf("Save Attempt           %9d\n", (int)_results.ttSaveAttempts);
-	printf("   Save Succeed        %9d\n", (int)_TT->numSaves());
-	printf("      Save Empty       %9d\n", (int)_TT->saveEmpty);
-	printf("      Save Self        %9d\n", (int)_TT->saveOverwriteSelf);
-	printf("      Save Other       %9d\n", (int)_TT->saveOverwriteOther);
-	printf("Look-Up                %9d\n", (int)_TT->numLookups());
-	printf("   Not Found           %9d\n", (int)_TT->numNotFound());
-	printf("   Collisions          %9d\n", (int)_TT->numCollisions());
-	printf("   Found               %9d\n", (int)_TT->numFound());
+	printf("   Save Succeed        %9d\n", (int)_results.ttSaves);
+	printf("      Save Empty       %9d\n", (int)_results.ttSaveEmpty);
+	printf("      Save Self        %9d\n", (int)_results.ttSaveSelf);
+	printf("      Save Other       %9d\n", (int)_results.ttSaveOther);
+	printf("Look-Up                %9d\n", (int)_results.ttLookups);
+	printf("   Not Found           %9d\n", (int)(_results.ttLookups - _results.ttFound));
+	printf("   Found               %9d\n", (int)_results.ttFound);
 	printf("      Less Depth       %9d\n", (int)_results.ttFoundLessDepth);
 	printf("      More Depth       %9d\n", ((int)_results.ttFoundCheck + (int)_results.ttcuts));
 	printf("         Cut           %9d\n", (int)_results.ttcuts);
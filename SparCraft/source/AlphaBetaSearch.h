@@ -14,9 +14,12 @@
 #include "AlphaBetaSearchResults.hpp"
 #include "AlphaBetaSearchParameters.hpp"
 #include "GraphViz.hpp"
+#include "SearchDeadline.hpp"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/multi_array.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/thread/mutex.hpp>
 
 namespace SparCraft
 {
@@ -41,11 +44,45 @@ class AlphaBetaSearch
 			Constants::Max_Search_Depth, 
 			Constants::Max_Ordered_Moves>   _orderedMoves;
 
+	// whether the ordered moves of each depth start with the table's move, and where the killers
+	// start in them, after the table's move and the scripts'
+	Array<bool,
+          Constants::Max_Search_Depth>      _hasTTMove;
+	Array<size_t,
+          Constants::Max_Search_Depth>      _killerIndex;
+
+	// History heuristic and killer moves. The history table scores each (player, unit type, action
+	// type, relative target) by the cuts it took part in, weighted by the depth they were made at,
+	// and orders the actions of every unit before the tuples are enumerated. The killers are the
+	// last tuples which caused a cut at each ply, tried again after the scripts
+	enum { Num_Killers = 2 };
+
+	std::vector<int>                        _history;
+	Array2D<std::vector<UnitAction>,
+			Constants::Max_Search_Depth,
+			Num_Killers>                    _killers;
+
     std::vector<PlayerPtr>					_allScripts[Constants::Num_Players];
     PlayerPtr                               _playerModels[Constants::Num_Players];
 
 	TTPtr                                   _TT;
 
+	// the time limit, when it runs out or the search is cancelled the recursion returns right away
+	// and the iteration it was in is thrown out
+	SearchDeadline                          _deadline;
+
+	// the moves of the last completed iteration, which another thread may read during the search
+	mutable boost::mutex                    _bestSoFarMutex;
+	std::vector<UnitAction>                 _bestSoFar;
+	size_t                                  _bestSoFarDepth;
+
+	// Lazy SMP state, a helper thread orders its moves with a generator of its own and stops
+	// once the deadline of the main thread is cancelled
+	size_t                                  _helper;            // 0 for the main thread
+	boost::random::mt19937                  _gen;
+	boost::random::mt19937 *                _random;
+	const SearchDeadline *                  _parentDeadline;
+
 public:
 
 	AlphaBetaSearch(const AlphaBetaSearchParameters & params, TTPtr TT = TTPtr((TranspositionTable *)NULL));
@@ -54,26 +91,40 @@ public:
 
 	// search functions
 	AlphaBetaValue IDAlphaBeta(GameState & initialState, const size_t & maxDepth);
+	AlphaBetaValue lazySMPSearch(GameState & initialState);
 	AlphaBetaValue alphaBeta(GameState & state, size_t depth, const IDType lastPlayerToMove, std::vector<UnitAction> * firstSimMove, StateEvalScore alpha, StateEvalScore beta);
 
 	// Transposition Table
 	TTLookupValue TTlookup(const GameState & state, StateEvalScore & alpha, StateEvalScore & beta, const size_t & depth);
 	void TTsave(GameState & state, const StateEvalScore & value, const StateEvalScore & alpha, const StateEvalScore & beta, const size_t & depth, 
-				const IDType & firstPlayer, const AlphaBetaMove & bestFirstMove, const AlphaBetaMove & bestSecondMove);
+				const IDType & playerToMove, const AlphaBetaMove & bestMove);
+	void setTranspositionTable(TTPtr TT);
 
 	// Transposition Table look up + alpha/beta update
 
 	// get the results from the search
 	AlphaBetaSearchResults & getResults();
+
+	// stops a running search, which still ends with the moves of its last completed iteration
+	void cancel();
+
+	// the moves of the last iteration the running search completed and its depth, 0 if none is done
+	const size_t getBestMovesSoFar(std::vector<UnitAction> & moveVec) const;
     	
 	void generateOrderedMoves(GameState & state, MoveArray & moves, const TTLookupValue & TTval, const IDType & playerToMove, const size_t & depth);
+	void orderMovesByHistory(GameState & state, MoveArray & moves, const IDType & playerToMove) const;
+	void updateMoveHistory(GameState & state, const std::vector<UnitAction> & moveVec, const IDType & playerToMove, const size_t & depth, const size_t & moveNumber);
+	const size_t getHistoryIndex(GameState & state, const UnitAction & move, const Position & enemyCenter) const;
+	const Position getEnemyCenter(const GameState & state, const IDType & player) const;
+	const bool isLegalMoveVec(const MoveArray & moves, const std::vector<UnitAction> & moveVec) const;
 	const IDType getEnemy(const IDType & player) const;
 	const IDType getPlayerToMove(GameState & state, const size_t & depth, const IDType & lastPlayerToMove, const bool isFirstSimMove) const;
 	bool getNextMoveVec(IDType playerToMove, MoveArray & moves, const size_t & moveNumber, const TTLookupValue & TTval, const size_t & depth, std::vector<UnitAction> & moveVec) const;
 	const size_t getNumMoves(MoveArray & moves, const TTLookupValue & TTval, const IDType & playerToMove, const size_t & depth) const;
-	const AlphaBetaMove & getAlphaBetaMove(const TTLookupValue & TTval, const IDType & playerToMove) const;
+	const AlphaBetaMove getAlphaBetaMove(const TTLookupValue & TTval, const MoveArray & moves, const IDType & playerToMove) const;
 	const bool searchTimeOut();
 	const bool isRoot(const size_t & depth) const;
+	const bool nullWindowFailed(const AlphaBetaValue & val, const StateEvalScore & alpha, const StateEvalScore & beta);
 	const bool terminalState(GameState & state, const size_t & depth) const;
 	const bool isTranspositionLookupState(GameState & state, const std::vector<UnitAction> * firstSimMove) const;
 
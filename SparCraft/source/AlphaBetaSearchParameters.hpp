@@ -20,6 +20,13 @@ class SparCraft::AlphaBetaSearchParameters
     IDType          _simScripts[2];                 // NOKDPS               Policy to use for playouts
 	IDType		    _playerToMoveMethod;		    // Alternate			The player to move policy
 	IDType		    _playerModel[2];                // None                 Player model to use for each player
+    size_t          _numThreads;                    // 1                    Threads of a Lazy SMP search sharing the transposition table
+    size_t          _transpositionTableMB;          // 4                    Size of the transposition table the search makes if it isn't given one
+    bool            _persistentTT;                  // false                Keep the transposition table between searches instead of clearing it
+    bool            _historyHeuristic;              // false                Order each unit's actions by how often they caused cuts
+    bool            _killerMoves;                   // false                Try the tuples which last caused cuts at the same ply after the scripts
+    ScoreType       _aspirationWindow;              // 0                    Half width of the root window around the last iteration's score. 0 means a full window
+    bool            _principalVariation;            // false                Search the children after the first with a null window, and again if that fails
 
     std::string     _graphVizFilename;              // ""                   File name to output graph viz file
 
@@ -39,6 +46,13 @@ public:
         , _moveOrdering         (MoveOrderMethod::ScriptFirst)
         , _evalMethod           (SparCraft::EvaluationMethods::Playout)
 	    , _playerToMoveMethod   (SparCraft::PlayerToMove::Alternate)
+        , _numThreads           (1)
+        , _transpositionTableMB (Constants::Transposition_Table_MB)
+        , _persistentTT         (false)
+        , _historyHeuristic     (false)
+        , _killerMoves          (false)
+        , _aspirationWindow     (0)
+        , _principalVariation   (false)
     {
 	    setPlayerModel(Players::Player_One, PlayerModels::None);
 	    setPlayerModel(Players::Player_Two, PlayerModels::None);
@@ -57,6 +71,13 @@ public:
     const IDType & playerModel(const IDType & player)	        const   { return _playerModel[player]; }
     const std::string & graphVizFilename()                      const   { return _graphVizFilename; }
     const std::vector<IDType> & getOrderedMoveScripts()         const   { return _orderedMoveScripts; }
+    const size_t & numThreads()                                 const   { return _numThreads; }
+    const size_t & transpositionTableMB()                       const   { return _transpositionTableMB; }
+    const bool & persistentTT()                                 const   { return _persistentTT; }
+    const bool & historyHeuristic()                             const   { return _historyHeuristic; }
+    const bool & killerMoves()                                  const   { return _killerMoves; }
+    const ScoreType & aspirationWindow()                        const   { return _aspirationWindow; }
+    const bool & principalVariation()                           const   { return _principalVariation; }
 	
     void setSearchMethod(const IDType & method)                         { _searchMethod = method; }
     void setMaxPlayer(const IDType & player)					        { _maxPlayer = player; }
@@ -71,6 +92,13 @@ public:
     void setGraphVizFilename(const std::string & filename)              { _graphVizFilename = filename; }
     void addOrderedMoveScript(const IDType & script)                    { _orderedMoveScripts.push_back(script); }
     void setPlayerModel(const IDType & player, const IDType & model)	{ _playerModel[player] = model; }	
+    void setNumThreads(const size_t & threads)                          { _numThreads = threads; }
+    void setTranspositionTableMB(const size_t & megabytes)              { _transpositionTableMB = megabytes; }
+    void setPersistentTT(const bool & persistent)                       { _persistentTT = persistent; }
+    void setHistoryHeuristic(const bool & history)                      { _historyHeuristic = history; }
+    void setKillerMoves(const bool & killers)                           { _killerMoves = killers; }
+    void setAspirationWindow(const ScoreType & window)                  { _aspirationWindow = window; }
+    void setPrincipalVariation(const bool & pvs)                        { _principalVariation = pvs; }
 
     std::vector<std::vector<std::string> > & getDescription()
     {
@@ -87,6 +115,13 @@ public:
             _desc[0].push_back("Move Ordering:");
             _desc[0].push_back("Player To Move:");
             _desc[0].push_back("Opponent Model:");
+            _desc[0].push_back("Threads:");
+            _desc[0].push_back("TT Size:");
+            _desc[0].push_back("Persistent TT:");
+            _desc[0].push_back("History Heuristic:");
+            _desc[0].push_back("Killer Moves:");
+            _desc[0].push_back("Aspiration Window:");
+            _desc[0].push_back("PVS:");
 
             ss << "AlphaBeta";                                              _desc[1].push_back(ss.str()); ss.str(std::string());
             ss << timeLimit() << "ms";                                      _desc[1].push_back(ss.str()); ss.str(std::string());
@@ -94,6 +129,13 @@ public:
             ss << MoveOrderMethod::getName(moveOrderingMethod());             _desc[1].push_back(ss.str()); ss.str(std::string());
             ss << PlayerToMove::getName(playerToMoveMethod());                _desc[1].push_back(ss.str()); ss.str(std::string());
             ss << PlayerModels::getName(playerModel((maxPlayer()+1)%2));   _desc[1].push_back(ss.str()); ss.str(std::string());
+            ss << numThreads();                                             _desc[1].push_back(ss.str()); ss.str(std::string());
+            ss << transpositionTableMB() << "MB";                           _desc[1].push_back(ss.str()); ss.str(std::string());
+            ss << (persistentTT() ? "true" : "false");                      _desc[1].push_back(ss.str()); ss.str(std::string());
+            ss << (historyHeuristic() ? "true" : "false");                  _desc[1].push_back(ss.str()); ss.str(std::string());
+            ss << (killerMoves() ? "true" : "false");                       _desc[1].push_back(ss.str()); ss.str(std::string());
+            ss << aspirationWindow();                                       _desc[1].push_back(ss.str()); ss.str(std::string());
+            ss << (principalVariation() ? "true" : "false");                _desc[1].push_back(ss.str()); ss.str(std::string());
         }
         
         return _desc;
@@ -22,6 +22,8 @@ public:
 	ScoreType			abValue;
 	unsigned long long  ttcuts;
 	size_t				maxDepthReached;	
+	unsigned long long	helperNodesExpanded;	// nodes expanded by the helper threads of a Lazy SMP search
+	size_t				helperMaxDepth;			// deepest iteration a helper thread got to
 
 	size_t				ttMoveOrders;
 	size_t				ttFoundButNoMove;
@@ -29,6 +31,16 @@ public:
 	size_t				ttFoundCheck;
 	size_t				ttFoundLessDepth;
 	size_t				ttSaveAttempts;
+	size_t				ttLookups;		// lookups and hits of the last search
+	size_t				ttFound;
+	size_t				ttSaves;
+	size_t				ttSaveEmpty;
+	size_t				ttSaveSelf;
+	size_t				ttSaveOther;
+	unsigned long long	cutoffs;		// alpha-beta cuts of the last search, and how many were made by the first move tried
+	unsigned long long	firstMoveCutoffs;
+	size_t				aspirationResearches;	// iterations searched again because their score fell outside the aspiration window
+	unsigned long long	pvsResearches;			// children searched again because they beat the null window
 
     std::vector<std::vector<std::string> > _desc;    // 2-column description vector
 	
@@ -41,12 +53,24 @@ public:
 		, abValue(0)
 		, ttcuts(0)
 		, maxDepthReached(0)
+		, helperNodesExpanded(0)
+		, helperMaxDepth(0)
 		, ttMoveOrders(0)
 		, ttFoundButNoMove(0)
 		, ttFoundNoCut(0)
 		, ttFoundCheck(0)
 		, ttFoundLessDepth(0)
 		, ttSaveAttempts(0)
+		, ttLookups(0)
+		, ttFound(0)
+		, ttSaves(0)
+		, ttSaveEmpty(0)
+		, ttSaveSelf(0)
+		, ttSaveOther(0)
+		, cutoffs(0)
+		, firstMoveCutoffs(0)
+		, aspirationResearches(0)
+		, pvsResearches(0)
 	{
 	}
 
@@ -61,10 +85,16 @@ public:
         _desc[0].push_back("Nodes Searched: ");
         _desc[0].push_back("AB Value: ");
         _desc[0].push_back("Max Depth: ");
+        _desc[0].push_back("TT Hit Rate: ");
+        _desc[0].push_back("First Move Cuts: ");
+        _desc[0].push_back("Re-searches: ");
 
         ss << nodesExpanded;       _desc[1].push_back(ss.str()); ss.str(std::string());
         ss << abValue;              _desc[1].push_back(ss.str()); ss.str(std::string());
         ss << maxDepthReached;     _desc[1].push_back(ss.str()); ss.str(std::string());
+        ss << (ttLookups ? (100 * ttFound / ttLookups) : 0) << "%";  _desc[1].push_back(ss.str()); ss.str(std::string());
+        ss << (cutoffs ? (100 * firstMoveCutoffs / cutoffs) : 0) << "%";  _desc[1].push_back(ss.str()); ss.str(std::string());
+        ss << aspirationResearches << " / " << pvsResearches;          _desc[1].push_back(ss.str()); ss.str(std::string());
         
         return _desc;
     }
@@ -2,9 +2,24 @@
 
 #include "Common.h"
 
+// Maximum number of units a player can have in this build. Define SPARCRAFT_UNIT_CAPACITY to size
+// every GameState, MoveArray and search for the battles the build will be used for. Everything
+// grows with it: at 256, which allows 150v150 fights, a MoveArray is about 1 MB and an
+// AlphaBetaSearch about 56 MB, while small builds keep whole states in cache
+#ifndef SPARCRAFT_UNIT_CAPACITY
+    #define SPARCRAFT_UNIT_CAPACITY 100
+#endif
+
 // type definitions for storing data
+// unit IDs count the units of both players and the largest value is reserved for 'no unit',
+// so builds for more than 127 units per player need 16 bit IDs
+#if SPARCRAFT_UNIT_CAPACITY > 127
+typedef		unsigned short		IDType;
+typedef		unsigned short		UnitCountType;
+#else
 typedef		unsigned char		IDType;
 typedef		unsigned char		UnitCountType;
+#endif
 typedef		unsigned char		ChildCountType;
 typedef 	int					PositionType;
 typedef 	int					TimeType;
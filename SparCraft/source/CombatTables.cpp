@@ -0,0 +1,129 @@
+#include "CombatTables.h"
+
+using namespace SparCraft;
+
+unsigned char                           CombatTables::typeIndex[Max_Types];
+bool                                    CombatTables::canAttackGround[Max_Types];
+bool                                    CombatTables::canAttackAir[Max_Types];
+bool                                    CombatTables::isFlyer[Max_Types];
+bool                                    CombatTables::canMove[Max_Types];
+HealthType                              CombatTables::groundDamage[Max_Types];
+TimeType                                CombatTables::cooldown[Max_Types];
+TimeType                                CombatTables::attackInitFrames[Max_Types];
+TimeType                                CombatTables::attackRepeatFrames[Max_Types];
+float                                   CombatTables::dpf[Max_Types];
+size_t                                  CombatTables::numTypes(0);
+std::vector<CombatTables::PairDamage>   CombatTables::pairDamage;
+
+unsigned char                           CombatTables::groundWeaponLevel[Constants::Num_Players][Max_Types];
+unsigned char                           CombatTables::airWeaponLevel[Constants::Num_Players][Max_Types];
+unsigned char                           CombatTables::armorBonus[Constants::Num_Players][Max_Types];
+HealthType                              CombatTables::armor[Constants::Num_Players][Max_Types];
+PositionType                            CombatTables::range[Constants::Num_Players][Max_Types];
+PositionType                            CombatTables::rangeSq[Constants::Num_Players][Max_Types];
+size_t                                  CombatTables::playerChanges(0);
+
+// must be called after the AnimationFrameData, WeaponProperties and UnitProperties are initialized
+void CombatTables::init()
+{
+    std::fill(typeIndex, typeIndex + Max_Types, (unsigned char)No_Type);
+    numTypes = 0;
+
+    std::vector<BWAPI::UnitType> types;
+
+    BOOST_FOREACH (const BWAPI::UnitType & type, BWAPI::UnitTypes::allUnitTypes())
+    {
+        const int id(type.getID());
+
+        if (id < 0 || id >= Max_Types)
+        {
+            continue;
+        }
+
+        canAttackGround[id]     = type.groundWeapon().damageAmount() > 0;
+        canAttackAir[id]        = type.airWeapon().damageAmount() > 0;
+        isFlyer[id]             = type.isFlyer();
+        canMove[id]             = type.canMove();
+        groundDamage[id]        = (HealthType)type.groundWeapon().damageAmount() * (type == BWAPI::UnitTypes::Protoss_Zealot ? 2 : 1);
+        cooldown[id]            = (TimeType)type.groundWeapon().damageCooldown();
+        attackInitFrames[id]    = 0;
+        attackRepeatFrames[id]  = 0;
+        dpf[id]                 = std::max(Constants::Min_Unit_DPF, (float)groundDamage[id] / ((float)cooldown[id] + 1));
+
+        // the frame data only has as many entries as there are unit types, and the ids have gaps, so
+        // the highest ids (the spells, None, Unknown and the unit groups) are past its end
+        if ((size_t)id < BWAPI::UnitTypes::allUnitTypes().size())
+        {
+            attackInitFrames[id]    = AnimationFrameData::getAttackFrames(type).first;
+            attackRepeatFrames[id]  = AnimationFrameData::getAttackFrames(type).second;
+        }
+
+        // only the types a Unit can be constructed with get a row in the damage table
+        if (System::isSupportedUnitType(type) || type == BWAPI::UnitTypes::Terran_Medic)
+        {
+            typeIndex[id] = (unsigned char)numTypes++;
+            types.push_back(type);
+        }
+    }
+
+    pairDamage = std::vector<PairDamage>(numTypes * numTypes);
+
+    for (size_t a(0); a < numTypes; ++a)
+    {
+        const BWAPI::UnitType & attacker(types[a]);
+
+        // special case where units attack multiple times
+        const int hits((attacker == BWAPI::UnitTypes::Protoss_Zealot || attacker == BWAPI::UnitTypes::Terran_Firebat) ? 2 : 1);
+
+        for (size_t t(0); t < numTypes; ++t)
+        {
+            const BWAPI::UnitType & target(types[t]);
+            const BWAPI::WeaponType weapon(target.isFlyer() ? attacker.airWeapon() : attacker.groundWeapon());
+            const float multiplier(damageMultipliers[weapon.damageType().getID()][target.size().getID()]);
+
+            PairDamage & pair(pairDamage[a * numTypes + t]);
+
+            for (int level(0); level < Max_Weapon_Levels; ++level)
+            {
+                const HealthType damageBase((HealthType)(weapon.damageAmount() + level * weapon.damageFactor()));
+
+                for (int bonus(0); bonus < Max_Armor_Bonus; ++bonus)
+                {
+                    const HealthType targetArmor((HealthType)(target.armor() + bonus));
+
+                    pair.damage[level][bonus] = (HealthType)(std::max((int)((damageBase - targetArmor) * multiplier), 2) * hits);
+                }
+            }
+        }
+    }
+
+    updatePlayers();
+}
+
+void CombatTables::updatePlayers()
+{
+    BOOST_FOREACH (const BWAPI::UnitType & type, BWAPI::UnitTypes::allUnitTypes())
+    {
+        const int id(type.getID());
+
+        if (id < 0 || id >= Max_Types)
+        {
+            continue;
+        }
+
+        for (IDType p(0); p < Constants::Num_Players; ++p)
+        {
+            const PlayerProperties & player(PlayerProperties::Get(p));
+            const int totalArmor(UnitProperties::Get(type).GetArmor(player));
+
+            groundWeaponLevel[p][id]    = (unsigned char)std::min(player.GetUpgradeLevel(type.groundWeapon().upgradeType()), Max_Weapon_Levels - 1);
+            airWeaponLevel[p][id]       = (unsigned char)std::min(player.GetUpgradeLevel(type.airWeapon().upgradeType()), Max_Weapon_Levels - 1);
+            armorBonus[p][id]           = (unsigned char)std::min(std::max(totalArmor - type.armor(), 0), Max_Armor_Bonus - 1);
+            armor[p][id]                = (HealthType)totalArmor;
+            range[p][id]                = PlayerWeapon(&player, type.groundWeapon()).GetMaxRange() + Constants::Range_Addition;
+            rangeSq[p][id]              = range[p][id] * range[p][id];
+        }
+    }
+
+    playerChanges = PlayerProperties::NumChanges();
+}
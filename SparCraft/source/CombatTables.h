@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Common.h"
+#include "PlayerProperties.h"
+#include "UnitProperties.h"
+#include "WeaponProperties.h"
+#include "AnimationFrameData.h"
+
+namespace SparCraft
+{
+
+// Flat lookup tables of everything the simulation needs to resolve an attack, so the Unit hot paths
+// don't have to go through the BWAPI type data, PlayerWeapon and UnitProperties on every hit.
+// Damage is stored per (attacker type, target type) pair as one 64 byte block holding the final
+// damage of a hit for every weapon upgrade level of the attacker and armor bonus of the target.
+// Values which depend on the PlayerProperties are cached per player and rebuilt whenever
+// PlayerProperties::NumChanges() says an upgrade or tech was changed
+class CombatTables
+{
+public:
+
+    enum { Max_Weapon_Levels = 4, Max_Armor_Bonus = 8, Max_Types = 256, No_Type = 255 };
+
+private:
+
+    struct PairDamage
+    {
+        HealthType      damage[Max_Weapon_Levels][Max_Armor_Bonus];
+    };
+
+    // tables which only depend on the unit types, indexed by BWAPI type ID
+    static unsigned char                typeIndex[Max_Types];           // dense index into pairDamage
+    static bool                         canAttackGround[Max_Types];
+    static bool                         canAttackAir[Max_Types];
+    static bool                         isFlyer[Max_Types];
+    static bool                         canMove[Max_Types];
+    static HealthType                   groundDamage[Max_Types];
+    static TimeType                     cooldown[Max_Types];
+    static TimeType                     attackInitFrames[Max_Types];
+    static TimeType                     attackRepeatFrames[Max_Types];
+    static float                        dpf[Max_Types];
+    static size_t                       numTypes;
+    static std::vector<PairDamage>      pairDamage;
+
+    // tables which depend on the upgrades of each player
+    static unsigned char                groundWeaponLevel[Constants::Num_Players][Max_Types];
+    static unsigned char                airWeaponLevel[Constants::Num_Players][Max_Types];
+    static unsigned char                armorBonus[Constants::Num_Players][Max_Types];
+    static HealthType                   armor[Constants::Num_Players][Max_Types];
+    static PositionType                 range[Constants::Num_Players][Max_Types];
+    static PositionType                 rangeSq[Constants::Num_Players][Max_Types];
+    static size_t                       playerChanges;
+
+    static void                         updatePlayers();
+
+    static void checkPlayers()
+    {
+        if (playerChanges != PlayerProperties::NumChanges())
+        {
+            updatePlayers();
+        }
+    }
+
+public:
+
+    static void init();
+
+    // damage of one hit including units which hit more than once per attack, like the Zealot
+    static const HealthType getDamage(const int & attackerType, const IDType & attackerPlayer, const int & targetType, const IDType & targetPlayer)
+    {
+        checkPlayers();
+
+        const unsigned char level(isFlyer[targetType] ? airWeaponLevel[attackerPlayer][attackerType] : groundWeaponLevel[attackerPlayer][attackerType]);
+
+        return pairDamage[typeIndex[attackerType] * numTypes + typeIndex[targetType]].damage[level][armorBonus[targetPlayer][targetType]];
+    }
+
+    // whether the attacker has a weapon which can hit the target's air / ground type
+    static const bool canAttack(const int & attackerType, const int & targetType)
+    {
+        return isFlyer[targetType] ? canAttackAir[attackerType] : canAttackGround[attackerType];
+    }
+
+    static const PositionType getRange(const int & type, const IDType & player)
+    {
+        checkPlayers();
+        return range[player][type];
+    }
+
+    static const PositionType getRangeSq(const int & type, const IDType & player)
+    {
+        checkPlayers();
+        return rangeSq[player][type];
+    }
+
+    static const HealthType getArmor(const int & type, const IDType & player)
+    {
+        checkPlayers();
+        return armor[player][type];
+    }
+
+    static const bool       getCanAttackGround(const int & type)        { return canAttackGround[type]; }
+    static const bool       getCanAttackAir(const int & type)           { return canAttackAir[type]; }
+    static const bool       getIsFlyer(const int & type)                { return isFlyer[type]; }
+    static const bool       getCanMove(const int & type)                { return canMove[type]; }
+    static const HealthType getGroundDamage(const int & type)           { return groundDamage[type]; }
+    static const TimeType   getCooldown(const int & type)               { return cooldown[type]; }
+    static const TimeType   getAttackInitFrames(const int & type)       { return attackInitFrames[type]; }
+    static const TimeType   getAttackRepeatFrames(const int & type)     { return attackRepeatFrames[type]; }
+    static const float      getDPF(const int & type)                    { return dpf[type]; }
+};
+
+}
@@ -24,8 +24,15 @@ namespace SparCraft
 		// number of players in the game
 		const size_t Num_Players				= 2;
 		
-		// maximum number of units a player can have
-		const size_t Max_Units					= 100;
+		// maximum number of units a player can have, see SPARCRAFT_UNIT_CAPACITY
+		const size_t Max_Units					= SPARCRAFT_UNIT_CAPACITY;
+
+		// IDType value of 'no unit', 'no player' or 'no move index'
+		const IDType No_ID						= (IDType)~0;
+
+		// unit grid cells are this many build tiles wide, the grid is at most this many cells on a side
+		const size_t Unit_Grid_Cell_Tiles		= 4;
+		const size_t Unit_Grid_Max_Cells		= 32;
 
 		// max depth the search can ever handle
 		const size_t Max_Search_Depth			= 50;
@@ -54,9 +61,12 @@ namespace SparCraft
 
 		// whether to use transposition table in search
 		const bool   Use_Transposition_Table	= true;
-		const size_t Transposition_Table_Size	= 100000;
-		const size_t Transposition_Table_Scan	= 10;
+		const size_t Transposition_Table_MB		= 4;
 		const size_t Num_Hashes					= 2;
+
+		// recompute the state hash from scratch on every calculateHash() and compare it
+		// with the incrementally updated one, only useful for debugging
+		const bool   Check_Incremental_Hash		= false;
         
         // UCT options
         const size_t Max_UCT_Children           = 10;
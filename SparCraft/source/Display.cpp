@@ -480,7 +480,7 @@ void Display::RenderInformation()
 							glEnd();
 						}
 
-						if (unit.ID() < 255)
+						if (unit.ID() != Constants::No_ID)
 						{
 							glEnable( GL_TEXTURE_2D );
 								glBindTexture( GL_TEXTURE_2D, unit.type().getID() );
@@ -11,4 +11,5 @@ void SparCraft::EnumDataInit()
     SearchNodeType::init();
     MoveOrderMethod::init();
     PlayerToMove::init();
+    ParallelMethods::init();
 }
\ No newline at end of file
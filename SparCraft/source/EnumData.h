@@ -183,6 +183,20 @@ public:
     }
 };
 
+class ParallelMethods : public EnumData<ParallelMethods>
+{
+public:
+    enum { None, RootParallel, TreeParallel, Size };
+    static void init()
+    {
+        setType("ParallelMethods");
+        names.resize(Size);
+        setData(None,           "None");
+        setData(RootParallel,   "Root");
+        setData(TreeParallel,   "Tree");
+    }
+};
+
 extern void EnumDataInit();
 
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "GameState.h"
 #include "Player.h"
 #include "Game.h"
+#include "ScriptPlayout.h"
+#include "TargetKernel.h"
+#include "CombatTables.h"
 
 using namespace SparCraft;
 
@@ -26,23 +29,58 @@ public:
     }
 };
 
+// orders unit indices by distance to a point, ties broken by unit ID
+class UnitDistanceCompare
+{
+    const UnitArrays & arrays;
+    IDType player;
+    PositionType x;
+    PositionType y;
+
+public:
+
+    UnitDistanceCompare(const UnitArrays & a, const IDType & p, const PositionType & px, const PositionType & py)
+        : arrays(a)
+        , player(p)
+        , x(px)
+        , y(py)
+    {
+
+    }
+
+	const bool operator() (const IDType & u1, const IDType & u2) const
+	{
+        const PositionType d1(arrays.distSq(player, u1, x, y));
+        const PositionType d2(arrays.distSq(player, u2, x, y));
+
+        return d1 < d2 || (d1 == d2 && arrays.ID(player, u1) < arrays.ID(player, u2));
+    }
+};
+
 // default constructor
 GameState::GameState()
 	: _map(NULL)
+    , _hashing(true)
 	, _currentTime(0)
 	, _maxUnits(Constants::Max_Units)
     , _sameHPFrames(0)
+    , _deadlock(false)
+    , _deadlockStale(false)
 {
 	_numUnits.fill(0);
 	_prevNumUnits.fill(0);
 	_numMovements.fill(0);
+    _hpSum.fill(0);
+    _ltdSum.fill(0);
+    _ltd2Sum.fill(0);
     _prevHPSum.fill(0);
-
-	for (size_t u(0); u<_maxUnits; ++u)
-	{
-        _unitIndex[0][u] = u;
-		_unitIndex[1][u] = u;
-	}
+    _numAttackers.fill(0);
+    _numMobileAttackers.fill(0);
+    _numMobileUnits.fill(0);
+    _unitHash.fill(0);
+    _timeHash.fill(0);
+    _timeHashScale.fill(1);
+    _neutralUnits.fill(Unit::Empty());
 }
 
 // construct state from a save file
@@ -54,26 +92,23 @@ GameState::GameState(const std::string & filename)
 // call this whenever we are done with moves
 void GameState::finishedMoving()
 {
-	// sort the unit vector based on time left to move
+	// re-sort the units which acted based on time left to move
 	sortUnits();
 
 	// update the current time of the state
 	updateGameTime();
 
-    // calculate the hp sum of each player
-    int hpSum[2];
-    for (IDType p(0); p<Constants::Num_Players; ++p)
-	{
-		hpSum[p] = 0;
+    // refresh the unit arrays to the new unit order and time
+    updateUnitArrays();
 
-		for (IDType u(0); u<numUnits(p); ++u)
-		{ 
-            hpSum[p] += getUnit(p, u).currentHP();
-        }
+    // positions of moving units depend on the time, so the deadlock has to be checked again
+    if (_deadlockStale || _numMobileUnits[0] > 0 || _numMobileUnits[1] > 0)
+    {
+        updateDeadlock();
     }
 
     // if the hp sums match the last hp sum
-    if (hpSum[0] == _prevHPSum[0] && hpSum[1] == _prevHPSum[1])
+    if (_hpSum[0] == _prevHPSum[0] && _hpSum[1] == _prevHPSum[1])
     {
         _sameHPFrames++;
     }
@@ -84,23 +119,222 @@ void GameState::finishedMoving()
 
     for (IDType p(0); p<Constants::Num_Players; ++p)
 	{
-        _prevHPSum[p] = hpSum[p];
+        _prevHPSum[p] = _hpSum[p];
+    }
+}
+
+// add (sign 1) or remove (sign -1) a living unit from the unit counts
+void GameState::countUnit(const Unit & unit, const int & sign)
+{
+    const IDType player(unit.player());
+
+    _numAttackers[player]       += (unit.damage() > 0)                      ? sign : 0;
+    _numMobileAttackers[player] += (unit.isMobile() && !unit.canHeal())     ? sign : 0;
+    _numMobileUnits[player]     += unit.isMobile()                          ? sign : 0;
+    _deadlockStale              = true;
+}
+
+namespace
+{
+    // fixed point scale of the LTD sums, fine enough to hold the float term of any unit exactly
+    const double LTD_Scale = 4294967296.0;
+
+    const long long ltdTerm(const HealthType & hp, const float & dpf)
+    {
+        return hp > 0 ? (long long)((double)(hp * dpf) * LTD_Scale) : 0;
+    }
+
+    const long long ltd2Term(const HealthType & hp, const float & dpf)
+    {
+        return hp > 0 ? (long long)((double)(sqrtf(hp) * dpf) * LTD_Scale) : 0;
+    }
+}
+
+// move a unit's share of the hp and LTD sums from its hp before an action to its current hp,
+// units at 0 hp or below are dead and count for nothing
+void GameState::updateHPSums(const Unit & unit, const HealthType & hpBefore)
+{
+    const IDType        player(unit.player());
+    const HealthType    hpAfter(unit.isAlive() ? unit.currentHP() : 0);
+    const float         dpf(unit.dpf());
+
+    _hpSum[player]      += hpAfter - std::max(hpBefore, (HealthType)0);
+    _ltdSum[player]     += ltdTerm(hpAfter, dpf) - ltdTerm(hpBefore, dpf);
+    _ltd2Sum[player]    += ltd2Term(hpAfter, dpf) - ltd2Term(hpBefore, dpf);
+}
+
+// A deadlock is when everyone is immobile and nobody can attack anyone. This only changes when
+// units move or die, so isTerminal() reads the flag which finishedMoving() keeps up to date
+void GameState::updateDeadlock()
+{
+    _deadlockStale = false;
+    _deadlock = false;
+
+    if (_numMobileAttackers[Players::Player_One] > 0 || _numMobileAttackers[Players::Player_Two] > 0)
+    {
+        return;
+    }
+
+	for (size_t u1(0); u1<numUnits(Players::Player_One); ++u1)
+	{
+		const Unit & unit1(getUnit(Players::Player_One, u1));
+
+		for (size_t u2(0); u2<numUnits(Players::Player_Two); ++u2)
+		{
+			const Unit & unit2(getUnit(Players::Player_Two, u2));
+
+			// if anyone can attack anyone else
+			if (unit1.canAttackTarget(unit2, _currentTime) || unit2.canAttackTarget(unit1, _currentTime))
+			{
+				// then there is no deadlock
+				return;
+			}
+		}
+	}
+	
+	// if everyone is immobile and nobody can attack, then there is a deadlock
+    _deadlock = true;
+}
+
+// copy the unit data into the unit arrays in the current sorted order
+void GameState::updateUnitArrays()
+{
+    for (IDType p(0); p<Constants::Num_Players; ++p)
+	{
+		for (IDType u(0); u<_numUnits[p]; ++u)
+		{ 
+            _unitArrays.set(p, u, getUnit(p, u), _currentTime);
+        }
     }
 }
 
+// the unit grid refers to units by their slot in _units and has to know their current sorted index
+void GameState::updateUnitGridIndices()
+{
+    if (!_unitGrid.isEnabled())
+    {
+        return;
+    }
+
+    for (IDType p(0); p<Constants::Num_Players; ++p)
+	{
+		for (IDType u(0); u<_prevNumUnits[p]; ++u)
+		{ 
+            _unitGrid.setUnitIndex(p, _units.slot(p, u), u);
+        }
+    }
+}
+
+// The state hash is kept up to date incrementally as units change:
+//   _unitHash      xor of the time independent hashes of all living units
+//   _timeHash      sum of key * B^t over the absolute cooldown times t of all living units
+//   _timeHashScale B^-currentTime, which turns the sum into one over times relative to now
+// so time advancing costs one multiplication instead of rehashing every unit.
+// The key is not the one the full rehash used to give. That one hashed each sorted slot's
+// interpolated position and cooldowns, so a unit which had just started to move hashed the same
+// whichever way it was going, one part way along the same as any move through that point, and the
+// transposition table took states with different futures to be equal. Now a unit is keyed by its ID and by where a move starts and ends,
+// so two states with equal keys also had equal old keys, but some the old key merged are kept apart
 const HashType GameState::calculateHash(const size_t & hashNum) const
 {
-	HashType hash(0);
+    if (!_hashing)
+    {
+        return recalculateHash(hashNum);
+    }
+
+	const HashType hash(_unitHash[hashNum] ^ Hash::hash32shift(_timeHash[hashNum] * _timeHashScale[hashNum]));
+
+    if (Constants::Check_Incremental_Hash && (hash != recalculateHash(hashNum)))
+    {
+        System::FatalError("GameState Error: incremental hash does not match recalculated hash");
+    }
+
+	return hash;
+}
+
+// calculates the state hash from scratch
+const HashType GameState::recalculateHash(const size_t & hashNum) const
+{
+	HashType unitHash(0);
+    HashType timeHash(0);
 
 	for (IDType p(0); p < Constants::Num_Players; ++p)
 	{
-		for (IDType u(0); u < _numUnits[p]; ++u)
+        // dead units may still be inside the sorted range until finishedMoving() is called
+		for (IDType u(0); u < _prevNumUnits[p]; ++u)
 		{
-			hash ^= Hash::magicHash(getUnit(p,u).calculateHash(hashNum, _currentTime), p, u);
+            const Unit & unit(getUnit(p, u));
+
+            if (unit.isAlive())
+            {
+			    unitHash ^= unit.calculateHash(hashNum);
+                timeHash += unit.calculateTimeHash(hashNum);
+            }
 		}
 	}
 
-	return hash;
+	return unitHash ^ Hash::hash32shift(timeHash * Hash::values[hashNum].timePowerInverse(_currentTime));
+}
+
+// switching the incremental hash back on rebuilds the running values from the living units
+void GameState::setHashing(const bool & hashing)
+{
+    const bool rebuild(hashing && !_hashing);
+
+    _hashing = hashing;
+
+    if (rebuild)
+    {
+        _unitHash.fill(0);
+        _timeHash.fill(0);
+
+        for (IDType p(0); p < Constants::Num_Players; ++p)
+        {
+            for (IDType u(0); u < _prevNumUnits[p]; ++u)
+            {
+                if (getUnit(p, u).isAlive())
+                {
+                    addUnitHash(getUnit(p, u));
+                }
+            }
+        }
+    }
+}
+
+void GameState::addUnitHash(const Unit & unit)
+{
+    if (!_hashing)
+    {
+        return;
+    }
+
+    for (size_t h(0); h < Constants::Num_Hashes; ++h)
+    {
+        _unitHash[h] ^= unit.calculateHash(h);
+        _timeHash[h] += unit.calculateTimeHash(h);
+    }
+}
+
+void GameState::removeUnitHash(const Unit & unit)
+{
+    if (!_hashing)
+    {
+        return;
+    }
+
+    for (size_t h(0); h < Constants::Num_Hashes; ++h)
+    {
+        _unitHash[h] ^= unit.calculateHash(h);
+        _timeHash[h] -= unit.calculateTimeHash(h);
+    }
+}
+
+void GameState::updateTimeHashScale()
+{
+    for (size_t h(0); h < Constants::Num_Hashes; ++h)
+    {
+        _timeHashScale[h] = Hash::values[h].timePowerInverse(_currentTime);
+    }
 }
 
 void GameState::generateMoves(MoveArray & moves, const IDType & playerIndex) const
@@ -119,20 +353,20 @@ void GameState::generateMoves(MoveArray & moves, const IDType & playerIndex) con
 
 	// we are interested in all simultaneous moves
 	// so return all units which can move at the same time as the first
-	TimeType firstUnitMoveTime = getUnit(playerIndex, 0).firstTimeFree();
+	TimeType firstUnitMoveTime = _unitArrays.firstTimeFree(playerIndex, 0);
 		
 	for (IDType unitIndex(0); unitIndex < _numUnits[playerIndex]; ++unitIndex)
 	{
-		// unit reference
-		const Unit & unit(getUnit(playerIndex,unitIndex));
-			
 		// if this unit can't move at the same time as the first
-		if (unit.firstTimeFree() != firstUnitMoveTime)
+		if (_unitArrays.firstTimeFree(playerIndex, unitIndex) != firstUnitMoveTime)
 		{
 			// stop checking
 			break;
 		}
 
+		// unit reference
+		const Unit & unit(getUnit(playerIndex,unitIndex));
+
 		if (unit.previousActionTime() == _currentTime && _currentTime != 0)
 		{
             System::FatalError("Previous Move Took 0 Time: " + unit.previousAction().moveString());
@@ -143,15 +377,36 @@ void GameState::generateMoves(MoveArray & moves, const IDType & playerIndex) con
 		// generate attack moves
 		if (unit.canAttackNow())
 		{
-			for (IDType u(0); u<_numUnits[enemyPlayer]; ++u)
-			{
-				const Unit & enemyUnit(getUnit(enemyPlayer, u));
-				if (unit.canAttackTarget(enemyUnit, _currentTime) && enemyUnit.isAlive())
-				{
-					moves.add(UnitAction(unitIndex, playerIndex, UnitActionTypes::ATTACK, u));
+            const unsigned char attackerFlags(_unitArrays.flags(playerIndex, unitIndex));
+            const PositionType  x(_unitArrays.x(playerIndex, unitIndex));
+            const PositionType  y(_unitArrays.y(playerIndex, unitIndex));
+            const PositionType  rangeSq(unit.range() * unit.range());
+
+            if (_unitGrid.isEnabled())
+            {
+                // the grid only returns living units in range, in index order
+                IDType targets[Constants::Max_Units];
+                const size_t numTargets(_unitGrid.inRange(_unitArrays, enemyPlayer, x, y, rangeSq, targets));
+
+                for (size_t t(0); t<numTargets; ++t)
+                {
+                    if (targets[t] < _numUnits[enemyPlayer] && _unitArrays.weaponCanTarget(attackerFlags, enemyPlayer, targets[t]))
+                    {
+                        moves.add(UnitAction(unitIndex, playerIndex, UnitActionTypes::ATTACK, targets[t]));
+                    }
+                }
+            }
+            else
+            {
+                UnitMask targets;
+                TargetKernel::getTargets(_unitArrays, enemyPlayer, _numUnits[enemyPlayer], attackerFlags, x, y, rangeSq, targets);
+
+			    for (size_t u(targets.next(0)); u<Constants::Max_Units; u = targets.next(u+1))
+			    {
+				    moves.add(UnitAction(unitIndex, playerIndex, UnitActionTypes::ATTACK, u));
                     //moves.add(UnitAction(unitIndex, playerIndex, UnitActionTypes::ATTACK, unit.ID()));
-				}
-			}
+			    }
+            }
 		}
 		else if (unit.canHealNow())
 		{
@@ -183,20 +438,8 @@ void GameState::generateMoves(MoveArray & moves, const IDType & playerIndex) con
 		// generate movement moves
 		if (unit.isMobile())
 		{
-            // In order to not move when we could be shooting, we want to move for the minimum of:
-            // 1) default move distance move time
-            // 2) time until unit can attack, or if it can attack, the next cooldown
-            double timeUntilAttack          = unit.nextAttackActionTime() - getTime();
-            timeUntilAttack                 = timeUntilAttack == 0 ? unit.attackCooldown() : timeUntilAttack;
-
-            // the default move duration
-            double defaultMoveDuration      = (double)Constants::Move_Distance / unit.speed();
-
-            // if we can currently attack
-            double chosenTime               = std::min(timeUntilAttack, defaultMoveDuration);
-
             // the chosen movement distance
-            PositionType moveDistance       = (PositionType)(chosenTime * unit.speed());
+            PositionType moveDistance       = getMoveDistance(unit);
 
             // DEBUG: If chosen move distance is ever 0, something is wrong
             if (moveDistance == 0)
@@ -210,16 +453,11 @@ void GameState::generateMoves(MoveArray & moves, const IDType & playerIndex) con
                 // the direction of this movement
               	Position dir(Constants::Move_Dir[d][0], Constants::Move_Dir[d][1]);
             
-                if (moveDistance == 0)
-                {
-                    printf("%lf %lf %lf\n", timeUntilAttack, defaultMoveDuration, chosenTime);
-                }
-
                 // the final destination position of the unit
                 Position dest = unit.pos() + Position(moveDistance*dir.x(), moveDistance*dir.y());
 
                 // if that poisition on the map is walkable
-                if (isWalkable(dest) || (unit.type().isFlyer() && isFlyable(dest)))
+                if (canMoveTo(unit, dest))
 				{
                     // add the move to the MoveArray
 					moves.add(UnitAction(unitIndex, playerIndex, UnitActionTypes::MOVE, d, dest));
@@ -236,9 +474,37 @@ void GameState::generateMoves(MoveArray & moves, const IDType & playerIndex) con
 }
 
 
+// In order to not move when we could be shooting, we want to move for the minimum of:
+// 1) default move distance move time
+// 2) time until unit can attack, or if it can attack, the next cooldown
+const PositionType GameState::getMoveDistance(const Unit & unit) const
+{
+    double timeUntilAttack          = unit.nextAttackActionTime() - getTime();
+    timeUntilAttack                 = timeUntilAttack == 0 ? unit.attackCooldown() : timeUntilAttack;
+
+    // the default move duration
+    double defaultMoveDuration      = (double)Constants::Move_Distance / unit.speed();
+
+    // if we can currently attack
+    double chosenTime               = std::min(timeUntilAttack, defaultMoveDuration);
+
+    return (PositionType)(chosenTime * unit.speed());
+}
+
+const bool GameState::canMoveTo(const Unit & unit, const Position & dest) const
+{
+    return isWalkable(dest) || (CombatTables::getIsFlyer(unit.typeID()) && isFlyable(dest));
+}
+
 void GameState::makeMoves(const std::vector<UnitAction> & moves)
 {    
-    if (moves.size() > 0)
+    makeMoves(moves.empty() ? NULL : &moves[0], moves.size());
+}
+
+// the moves are numMoves contiguous actions, like the moves of a UCT tree's nodes
+void GameState::makeMoves(const UnitAction * moves, const size_t & numMoves)
+{    
+    if (numMoves > 0)
     {
         const IDType canMove(whoCanMove());
         const IDType playerToMove(moves[0].player());
@@ -248,7 +514,7 @@ void GameState::makeMoves(const std::vector<UnitAction> & moves)
         }
     }
     
-    for (size_t m(0); m<moves.size(); ++m)
+    for (size_t m(0); m<numMoves; ++m)
     {
         performUnitAction(moves[m]);
     }
@@ -260,6 +526,15 @@ void GameState::performUnitAction(const UnitAction & move)
 	IDType player		= ourUnit.player();
 	IDType enemyPlayer  = getEnemy(player);
 
+    // a unit killed earlier in the same simultaneous move still performs its action,
+    // but it no longer contributes to the hash
+    const bool ourUnitAlive(ourUnit.isAlive());
+
+    if (ourUnitAlive)
+    {
+        removeUnitHash(ourUnit);
+    }
+
 	if (move._moveType == UnitActionTypes::ATTACK)
 	{
 		Unit & enemyUnit(getUnit(enemyPlayer,move._moveIndex));
@@ -271,6 +546,9 @@ void GameState::performUnitAction(const UnitAction & move)
 		// enemy unit takes damage if it is alive
 		if (enemyUnit.isAlive())
 		{				
+                removeUnitHash(enemyUnit);
+
+            const HealthType hpBefore(enemyUnit.currentHP());
 			enemyUnit.takeAttack(ourUnit);
 
 			// check to see if enemy unit died
@@ -278,7 +556,22 @@ void GameState::performUnitAction(const UnitAction & move)
 			{
 				// if it died, remove it
 				_numUnits[enemyPlayer]--;
+                    _rekeyedUnits[enemyPlayer].set(move._moveIndex);
+                    updateHPSums(enemyUnit, hpBefore);
+                    countUnit(enemyUnit, -1);
+
+                    if (_unitGrid.isEnabled())
+                    {
+                        _unitGrid.remove(enemyPlayer, _units.slot(enemyPlayer, move._moveIndex));
+                    }
 			}
+                else
+                {
+                    updateHPSums(enemyUnit, hpBefore);
+                    addUnitHash(enemyUnit);
+                }
+
+                _unitArrays.update(enemyPlayer, move._moveIndex, enemyUnit);
 		}			
 	}
 	else if (move._moveType == UnitActionTypes::MOVE)
@@ -286,6 +579,12 @@ void GameState::performUnitAction(const UnitAction & move)
 		_numMovements[player]++;
 
 		ourUnit.move(move, _currentTime);
+        _deadlockStale = true;
+
+            if (ourUnitAlive && _unitGrid.isEnabled())
+            {
+                _unitGrid.move(player, _units.slot(player, move._unit), ourUnit);
+            }
 	}
 	else if (move._moveType == UnitActionTypes::HEAL)
 	{
@@ -296,7 +595,13 @@ void GameState::performUnitAction(const UnitAction & move)
 			
 		if (ourOtherUnit.isAlive())
 		{
+                removeUnitHash(ourOtherUnit);
+                const HealthType hpBefore(ourOtherUnit.currentHP());
 			ourOtherUnit.takeHeal(ourUnit);
+                updateHPSums(ourOtherUnit, hpBefore);
+                addUnitHash(ourOtherUnit);
+
+                _unitArrays.update(player, move._moveIndex, ourOtherUnit);
 		}
 	}
 	else if (move._moveType == UnitActionTypes::RELOAD)
@@ -307,6 +612,14 @@ void GameState::performUnitAction(const UnitAction & move)
 	{
 		ourUnit.pass(move, _currentTime);
 	}
+
+    if (ourUnitAlive)
+    {
+        addUnitHash(ourUnit);
+    }
+
+    _unitArrays.update(move._player, move._unit, ourUnit);
+    _rekeyedUnits[move._player].set(move._unit);
 }
 
 const Unit & GameState::getUnitByID(const IDType & unitID) const
@@ -383,22 +696,27 @@ const IDType GameState::getEnemy(const IDType & player) const
 
 const Unit & GameState::getClosestOurUnit(const IDType & player, const IDType & unitIndex)
 {
-	const Unit & myUnit(getUnit(player,unitIndex));
-
 	size_t minDist(1000000);
 	IDType minUnitInd(0);
 
-	Position currentPos = myUnit.currentPosition(_currentTime);
+	const PositionType x(_unitArrays.x(player, unitIndex));
+	const PositionType y(_unitArrays.y(player, unitIndex));
+
+    if (_unitGrid.isEnabled())
+    {
+        const int closest(_unitGrid.closest(_unitArrays, player, x, y, minDist, -1, false, unitIndex, UnitArrays::Healer));
+
+        return getUnit(player, closest >= 0 ? closest : minUnitInd);
+    }
 
 	for (IDType u(0); u<_numUnits[player]; ++u)
 	{
-		if (u == unitIndex || getUnit(player, u).canHeal())
+		if (u == unitIndex || _unitArrays.is(player, u, UnitArrays::Healer))
 		{
 			continue;
 		}
 
-		//size_t distSq(myUnit.distSq(getUnit(enemyPlayer,u)));
-		size_t distSq(currentPos.getDistanceSq(getUnit(player, u).currentPosition(_currentTime)));
+		size_t distSq(_unitArrays.distSq(player, u, x, y));
 
 		if (distSq < minDist)
 		{
@@ -413,30 +731,36 @@ const Unit & GameState::getClosestOurUnit(const IDType & player, const IDType &
 const Unit & GameState::getClosestEnemyUnit(const IDType & player, const IDType & unitIndex)
 {
 	const IDType enemyPlayer(getEnemy(player));
-	const Unit & myUnit(getUnit(player,unitIndex));
 
 	PositionType minDist(1000000);
 	IDType minUnitInd(0);
-    IDType minUnitID(255);
+    IDType minUnitID(Constants::No_ID);
+
+	const PositionType x(_unitArrays.x(player, unitIndex));
+	const PositionType y(_unitArrays.y(player, unitIndex));
 
-	Position currentPos = myUnit.currentPosition(_currentTime);
+    if (_unitGrid.isEnabled())
+    {
+        const int closest(_unitGrid.closest(_unitArrays, enemyPlayer, x, y, minDist, minUnitID, true, -1, 0));
+
+        return getUnit(enemyPlayer, closest >= 0 ? closest : minUnitInd);
+    }
 
 	for (IDType u(0); u<_numUnits[enemyPlayer]; ++u)
 	{
-        Unit & enemyUnit(getUnit(enemyPlayer, u));
-        PositionType distSq = myUnit.getDistanceSqToUnit(enemyUnit, _currentTime);
+        PositionType distSq = _unitArrays.distSq(enemyPlayer, u, x, y);
 
 		if ((distSq < minDist))// || ((distSq == minDist) && (enemyUnit.ID() < minUnitID)))
 		{
 			minDist = distSq;
 			minUnitInd = u;
-            minUnitID = enemyUnit.ID();
+            minUnitID = _unitArrays.ID(enemyPlayer, u);
 		}
-        else if ((distSq == minDist) && (enemyUnit.ID() < minUnitID))
+        else if ((distSq == minDist) && (_unitArrays.ID(enemyPlayer, u) < minUnitID))
         {
             minDist = distSq;
 			minUnitInd = u;
-            minUnitID = enemyUnit.ID();
+            minUnitID = _unitArrays.ID(enemyPlayer, u);
         }
 	}
 
@@ -448,7 +772,7 @@ const bool GameState::checkFull(const IDType & player) const
     if (numUnits(player) >= Constants::Max_Units)
     {
         std::stringstream ss;
-        ss << "GameState has too many units. Constants::Max_Units = " << Constants::Max_Units;
+        ss << "GameState has too many units. Constants::Max_Units = " << Constants::Max_Units << ", rebuild with a larger SPARCRAFT_UNIT_CAPACITY";
         System::FatalError(ss.str());
         return false;
     }
@@ -468,8 +792,14 @@ void GameState::addUnit(const Unit & u)
     IDType unitID = _numUnits[Players::Player_One] + _numUnits[Players::Player_Two];
 
     // Set the unit and it's unitID
+    _units.add(u.player(), _numUnits[u.player()]);
 	getUnit(u.player(), _numUnits[u.player()]) = u;
     getUnit(u.player(), _numUnits[u.player()]).setUnitID(unitID);
+    addUnitHash(getUnit(u.player(), _numUnits[u.player()]));
+    addUnitToGrid(u.player(), _numUnits[u.player()]);
+    _rekeyedUnits[u.player()].set(_numUnits[u.player()]);
+    updateHPSums(getUnit(u.player(), _numUnits[u.player()]), 0);
+    countUnit(getUnit(u.player(), _numUnits[u.player()]), 1);
 
     // Increment the number of units this player has
 	_numUnits[u.player()]++;
@@ -497,8 +827,14 @@ void GameState::addUnit(const BWAPI::UnitType type, const IDType playerID, const
     IDType unitID = _numUnits[Players::Player_One] + _numUnits[Players::Player_Two];
 
     // Set the unit and it's unitID
+    _units.add(playerID, _numUnits[playerID]);
 	getUnit(playerID, _numUnits[playerID]) = Unit(type, playerID, pos);
     getUnit(playerID, _numUnits[playerID]).setUnitID(unitID);
+    addUnitHash(getUnit(playerID, _numUnits[playerID]));
+    addUnitToGrid(playerID, _numUnits[playerID]);
+    _rekeyedUnits[playerID].set(_numUnits[playerID]);
+    updateHPSums(getUnit(playerID, _numUnits[playerID]), 0);
+    countUnit(getUnit(playerID, _numUnits[playerID]), 1);
 
     // Increment the number of units this player has
 	_numUnits[playerID]++;
@@ -522,7 +858,13 @@ void GameState::addUnitWithID(const Unit & u)
     System::checkSupportedUnitType(u.type());
 
     // Simply add the unit to the array
+    _units.add(u.player(), _numUnits[u.player()]);
 	getUnit(u.player(), _numUnits[u.player()]) = u;
+    addUnitHash(u);
+    addUnitToGrid(u.player(), _numUnits[u.player()]);
+    _rekeyedUnits[u.player()].set(_numUnits[u.player()]);
+    updateHPSums(getUnit(u.player(), _numUnits[u.player()]), 0);
+    countUnit(getUnit(u.player(), _numUnits[u.player()]), 1);
 
     // Increment the number of units this player has
 	_numUnits[u.player()]++;
@@ -538,69 +880,85 @@ void GameState::addUnitWithID(const Unit & u)
     }
 }
 
+// Units stay sorted by time free between moves, and the units which can act at the current time
+// are the front of that order. Only the units which acted, died or were added since the last
+// call change their place, so they are sorted on their own and merged back into the others
+// rather than sorting every unit again
 void GameState::sortUnits()
 {
-	// sort the units based on time free
-	for (size_t p(0); p<Constants::Num_Players; ++p)
+	for (IDType p(0); p<Constants::Num_Players; ++p)
 	{
-		if (_prevNumUnits[p] <= 1)
-		{
-			_prevNumUnits[p] = _numUnits[p];
-			continue;
-		}
-		else
+		if (_prevNumUnits[p] > 1 && !_rekeyedUnits[p].isEmpty())
 		{
-			/*for (int i=1; i<_prevNumUnits[p]; ++i)
-			{
-				// A[ i ] is added in the sorted sequence A[0, .. i-1]
-				// save A[i] to make a hole at index iHole
-				//Unit * item = _unitPtrs[p][i];
-                int itemIndex = _unitIndex[p][i];
-                Unit & itemUnit = getUnit(p, i);
-                int iHole = i;
-				// keep moving the hole to next smaller index until A[iHole - 1] is <= item
-				//while ((iHole > 0) && (*item < *(_unitPtrs[p][iHole - 1])))
-                while ((iHole > 0) && (itemUnit < getUnit(p, iHole-1)))
-				{
-					// move hole to next smaller index
-					//_unitPtrs[p][iHole] = _unitPtrs[p][iHole - 1];
-                    _unitIndex[p][iHole] = _unitIndex[p][iHole - 1];
-					iHole = iHole - 1;
-				}
-				// put item in the hole
-                _unitIndex[p][iHole] = itemIndex;
-				//_unitPtrs[p][iHole] = item;
-			}*/
-	
-			
-			//_unitPtrs[p].sort(_prevNumUnits[p], UnitPtrCompare());
-            std::sort(&_unitIndex[p][0], &_unitIndex[p][0] + _prevNumUnits[p], UnitIndexCompare(*this, p));
-			_prevNumUnits[p] = _numUnits[p];
+            mergeRekeyedUnits(p);
 		}
+
+        _rekeyedUnits[p].clear();
+		_prevNumUnits[p] = _numUnits[p];
 	}	
+
+    updateUnitGridIndices();
+}
+
+// The units which were not rekeyed are all alive and still in order, and living units have a
+// strict order on time free and unit ID, so this gives the same order as sorting all of them
+void GameState::mergeRekeyedUnits(const IDType & player)
+{
+    int *           unitIndex(_units.unitIndex(player));
+    const size_t    numUnits(_prevNumUnits[player]);
+
+    int             settled[Constants::Max_Units];
+    int             rekeyed[Constants::Max_Units];
+    size_t          numSettled(0);
+    size_t          numRekeyed(0);
+
+    for (size_t u(0); u < numUnits; ++u)
+    {
+        if (_rekeyedUnits[player].contains(u))
+        {
+            rekeyed[numRekeyed++] = unitIndex[u];
+        }
+        else
+        {
+            settled[numSettled++] = unitIndex[u];
+        }
+    }
+
+    std::sort(rekeyed, rekeyed + numRekeyed, UnitIndexCompare(*this, player));
+    std::merge(settled, settled + numSettled, rekeyed, rekeyed + numRekeyed, unitIndex, UnitIndexCompare(*this, player));
 }
 
 Unit & GameState::getUnit(const IDType & player, const UnitCountType & unitIndex)
 {
-    return _units[player][_unitIndex[player][unitIndex]];
+    return _units.get(player, unitIndex);
 }
 
 const Unit & GameState::getUnit(const IDType & player, const UnitCountType & unitIndex) const
 {
-    return _units[player][_unitIndex[player][unitIndex]];
+    return _units.get(player, unitIndex);
 }
 
+// squared distance to the closest enemy unit, 0 if there are no enemy units
 const size_t GameState::closestEnemyUnitDistance(const Unit & unit) const
 {
 	IDType enemyPlayer(getEnemy(unit.player()));
 
+    const Position & pos(unit.currentPosition(_currentTime));
+
+    if (_unitGrid.isEnabled())
+    {
+        const int closest(_unitGrid.closest(_unitArrays, enemyPlayer, pos.x(), pos.y(), std::numeric_limits<PositionType>::max(), Constants::No_ID, true, -1, 0));
+
+        return closest >= 0 ? _unitArrays.distSq(enemyPlayer, closest, pos.x(), pos.y()) : 0;
+    }
+
 	size_t closestDist(0);
 
 	for (IDType u(0); u<numUnits(enemyPlayer); ++u)
 	{
-        size_t dist(unit.getDistanceSqToUnit(getUnit(enemyPlayer, u), _currentTime));
+        size_t dist(_unitArrays.distSq(enemyPlayer, u, pos.x(), pos.y()));
 
-		if (dist > closestDist)
+		if (u == 0 || dist < closestDist)
 		{
 			closestDist = dist;
 		}
@@ -609,22 +967,102 @@ const size_t GameState::closestEnemyUnitDistance(const Unit & unit) const
 	return closestDist;
 }
 
-const bool GameState::playerDead(const IDType & player) const
+// writes the indices of the k enemy units closest to the given unit, closest first
+const size_t GameState::getClosestEnemyUnits(const IDType & player, const IDType & unitIndex, const size_t & k, IDType * unitIndices) const
 {
-	if (numUnits(player) <= 0)
-	{
-		return true;
-	}
+	const IDType enemyPlayer(getEnemy(player));
+    const size_t num(std::min(k, numUnits(enemyPlayer)));
+
+	const PositionType x(_unitArrays.x(player, unitIndex));
+	const PositionType y(_unitArrays.y(player, unitIndex));
+
+    if (_unitGrid.isEnabled())
+    {
+        return _unitGrid.closestK(_unitArrays, enemyPlayer, x, y, num, unitIndices);
+    }
+
+    IDType enemyUnits[Constants::Max_Units];
+    for (IDType u(0); u<numUnits(enemyPlayer); ++u)
+    {
+        enemyUnits[u] = u;
+    }
+
+    std::partial_sort(enemyUnits, enemyUnits + num, enemyUnits + numUnits(enemyPlayer), UnitDistanceCompare(_unitArrays, enemyPlayer, x, y));
+    std::copy(enemyUnits, enemyUnits + num, unitIndices);
+
+    return num;
+}
 
-	for (size_t u(0); u<numUnits(player); ++u)
+// writes the indices of all enemy units within range of the given unit, in index order
+const size_t GameState::getEnemyUnitsInRange(const IDType & player, const IDType & unitIndex, const PositionType & range, IDType * unitIndices) const
+{
+	const IDType enemyPlayer(getEnemy(player));
+    const PositionType rangeSq(range * range);
+
+	const PositionType x(_unitArrays.x(player, unitIndex));
+	const PositionType y(_unitArrays.y(player, unitIndex));
+
+    if (_unitGrid.isEnabled())
+    {
+        return _unitGrid.inRange(_unitArrays, enemyPlayer, x, y, rangeSq, unitIndices);
+    }
+
+    size_t num(0);
+    for (IDType u(0); u<numUnits(enemyPlayer); ++u)
+    {
+        if (_unitArrays.distSq(enemyPlayer, u, x, y) <= rangeSq)
+        {
+            unitIndices[num++] = u;
+        }
+    }
+
+    return num;
+}
+
+// sets the bits of the enemy units the given unit could attack right now if its weapon was ready
+void GameState::getAttackTargets(const IDType & player, const IDType & unitIndex, UnitMask & targets) const
+{
+    const PositionType range(getUnit(player, unitIndex).range());
+
+    TargetKernel::getTargets(_unitArrays, getEnemy(player), _numUnits[getEnemy(player)], _unitArrays.flags(player, unitIndex), 
+                             _unitArrays.x(player, unitIndex), _unitArrays.y(player, unitIndex), range * range, targets);
+}
+
+void GameState::enableUnitGrid()
+{
+    _unitGrid.reset(_map);
+
+    for (IDType p(0); p<Constants::Num_Players; ++p)
 	{
-		if (getUnit(player, u).damage() > 0)
-		{
-			return false;
-		}
-	}
+		for (IDType u(0); u<_prevNumUnits[p]; ++u)
+		{ 
+            if (getUnit(p, u).isAlive())
+            {
+                _unitGrid.insert(p, _units.slot(p, u), getUnit(p, u));
+            }
+        }
+    }
 
-	return true;
+    updateUnitGridIndices();
+}
+
+const bool GameState::usingUnitGrid() const
+{
+    return _unitGrid.isEnabled();
+}
+
+void GameState::addUnitToGrid(const IDType & player, const UnitCountType & unitIndex)
+{
+    if (_unitGrid.isEnabled())
+    {
+        _unitGrid.insert(player, _units.slot(player, unitIndex), getUnit(player, unitIndex));
+    }
+}
+
+// a player without units that can attack has lost
+const bool GameState::playerDead(const IDType & player) const
+{
+	return numUnits(player) <= 0 || _numAttackers[player] == 0;
 }
 
 const IDType GameState::whoCanMove() const
@@ -685,6 +1123,8 @@ void GameState::updateGameTime()
 	{
 		_currentTime = getUnit(Players::Player_Two, 0).firstTimeFree();
 	}
+
+    updateTimeHashScale();
 }
 
 const StateEvalScore GameState::eval(const IDType & player, const IDType & evalMethod, const IDType p1Script, const IDType p2Script) const
@@ -753,16 +1193,13 @@ const StateEvalScore GameState::evalSim(const IDType & player, const IDType & p1
 	const IDType p1Model = (p1Script == PlayerModels::Random) ? PlayerModels::NOKDPS : p1Script;
 	const IDType p2Model = (p2Script == PlayerModels::Random) ? PlayerModels::NOKDPS : p2Script;
 
-	PlayerPtr p1(AllPlayers::getPlayerPtr(Players::Player_One, p1Model));
-	PlayerPtr p2(AllPlayers::getPlayerPtr(Players::Player_Two, p2Model));
-
-	Game game(*this, p1, p2, 200);
+	ScriptPlayout playout(*this, p1Model, p2Model, 200);
 
-	game.play();
+	playout.play();
 
-	ScoreType evalReturn = game.getState().evalLTD2(player);
+	ScoreType evalReturn = playout.getState().evalLTD2(player);
 
-	return StateEvalScore(evalReturn, game.getState().getNumMovements(player));
+	return StateEvalScore(evalReturn, playout.getState().getNumMovements(player));
 }
 
 void GameState::calculateStartingHealth()
@@ -790,14 +1227,7 @@ const ScoreType	GameState::LTD2(const IDType & player) const
 		return 0;
 	}
 
-	float sum(0);
-
-	for (IDType u(0); u<numUnits(player); ++u)
-	{
-		const Unit & unit(getUnit(player, u));
-
-		sum += sqrtf(unit.currentHP()) * unit.dpf();
-	}
+	const float sum((float)(_ltd2Sum[player] / LTD_Scale));
 
 	ScoreType ret = (ScoreType)(1000 * sum / _totalSumSQRT[player]);
 
@@ -811,14 +1241,7 @@ const ScoreType GameState::LTD(const IDType & player) const
 		return 0;
 	}
 
-	float sum(0);
-
-	for (IDType u(0); u<numUnits(player); ++u)
-	{
-		const Unit & unit(getUnit(player, u));
-
-		sum += unit.currentHP() * unit.dpf();
-	}
+	const float sum((float)(_ltdSum[player] / LTD_Scale));
 
 	return (ScoreType)(1000 * sum / _totalLTD[player]);
 }
@@ -827,6 +1250,12 @@ void GameState::setMap(Map * map)
 {
 	_map = map;
 
+    // the grid is sized to the map
+    if (_unitGrid.isEnabled())
+    {
+        enableUnitGrid();
+    }
+
     // check to see if all units are on walkable tiles
     for (size_t p(0); p<Constants::Num_Players; ++p)
     {
@@ -867,6 +1296,11 @@ const bool GameState::bothCanMove() const
 void GameState::setTime(const TimeType & time)
 {
 	_currentTime = time;
+
+    // unit positions, the hash and the deadlock depend on the current time
+    updateUnitArrays();
+    updateTimeHashScale();
+    updateDeadlock();
 }
 
 const int & GameState::getNumMovements(const IDType & player) const
@@ -909,39 +1343,7 @@ const bool GameState::isTerminal() const
         return true;
     }
 
-	for (size_t p(0); p<Constants::Num_Players; ++p)
-	{
-		for (size_t u(0); u<numUnits(p); ++u)
-		{
-			// if any unit on any team is a mobile attacker
-			if (getUnit(p, u).isMobile() && !getUnit(p, u).canHeal())
-			{
-				// there is no deadlock, so return false
-				return false;
-			}
-		}
-	}
-
-	// at this point we know everyone must be immobile, so check for attack deadlock
-	for (size_t u1(0); u1<numUnits(Players::Player_One); ++u1)
-	{
-		const Unit & unit1(getUnit(Players::Player_One, u1));
-
-		for (size_t u2(0); u2<numUnits(Players::Player_Two); ++u2)
-		{
-			const Unit & unit2(getUnit(Players::Player_Two, u2));
-
-			// if anyone can attack anyone else
-			if (unit1.canAttackTarget(unit2, _currentTime) || unit2.canAttackTarget(unit1, _currentTime))
-			{
-				// then there is no deadlock
-				return false;
-			}
-		}
-	}
-	
-	// if everyone is immobile and nobody can attack, then there is a deadlock
-	return true;
+    return _deadlock;
 }
 
 void GameState::setTotalLTD2(const float & p1, const float & p2)
@@ -965,6 +1367,11 @@ const Unit & GameState::getNeutralUnit(const size_t & u) const
 	return _neutralUnits[u];
 }
 
+const UnitArrays & GameState::getUnitArrays() const
+{
+	return _unitArrays;
+}
+
 void GameState::addNeutralUnit(const Unit & unit)
 {
 	_neutralUnits.add(unit);
@@ -2,10 +2,15 @@
 
 #include "Common.h"
 #include <algorithm>
+#include <limits>
 #include "MoveArray.h"
 #include "Hash.h"
 #include "Map.hpp"
 #include "Unit.h"
+#include "UnitArrays.hpp"
+#include "UnitGrid.h"
+#include "UnitMask.hpp"
+#include "UnitSlots.hpp"
 #include "GraphViz.hpp"
 #include "Array.hpp"
 #include "Logger.h"
@@ -18,28 +23,65 @@ class GameState
 {
     Map *                                                           _map;               
 
-    Array2D<Unit, Constants::Num_Players, Constants::Max_Units>     _units;             
-    Array2D<int, Constants::Num_Players, Constants::Max_Units>      _unitIndex;        
+    UnitSlots                                                       _units;             
     Array<Unit, 1>                                                  _neutralUnits;
+    UnitArrays                                                      _unitArrays;
+    UnitGrid                                                        _unitGrid;
 
     Array<UnitCountType, Constants::Num_Players>                    _numUnits;
     Array<UnitCountType, Constants::Num_Players>                    _prevNumUnits;
 
+    // sorted indices of the units whose time free or alive status changed since the last sortUnits()
+    Array<UnitMask, Constants::Num_Players>                         _rekeyedUnits;
+
     Array<float, Constants::Num_Players>                            _totalLTD;
     Array<float, Constants::Num_Players>                            _totalSumSQRT;
 
     Array<int, Constants::Num_Players>                              _numMovements;
+    Array<int, Constants::Num_Players>                              _hpSum;
+
+    // running sums of hp * dpf and sqrt(hp) * dpf over the living units for the LTD and LTD2
+    // evaluations, in fixed point so they don't depend on the order the units changed in
+    Array<long long, Constants::Num_Players>                        _ltdSum;
+    Array<long long, Constants::Num_Players>                        _ltd2Sum;
     Array<int, Constants::Num_Players>                              _prevHPSum;
+
+    // counts of living units by kind, kept up to date as units are added and die
+    Array<UnitCountType, Constants::Num_Players>                    _numAttackers;
+    Array<UnitCountType, Constants::Num_Players>                    _numMobileAttackers;
+    Array<UnitCountType, Constants::Num_Players>                    _numMobileUnits;
+
+    // running hash values, see calculateHash()
+    Array<HashType, Constants::Num_Hashes>                          _unitHash;
+    Array<HashType, Constants::Num_Hashes>                          _timeHash;
+    Array<HashType, Constants::Num_Hashes>                          _timeHashScale;
+    bool                                                            _hashing;
 	
     TimeType                                                        _currentTime;
     size_t                                                          _maxUnits;
     TimeType                                                        _sameHPFrames;
 
+    // whether nobody can move to or attack anyone, see updateDeadlock()
+    bool                                                            _deadlock;
+    bool                                                            _deadlockStale;
+
     // checks to see if the unit array is full before adding a unit to the state
     const bool              checkFull(const IDType & player)                                        const;
     const bool              checkUniqueUnitIDs()                                                    const;
 
     void                    performUnitAction(const UnitAction & theMove);
+    void                    updateUnitArrays();
+    void                    updateUnitGridIndices();
+    void                    mergeRekeyedUnits(const IDType & player);
+    void                    countUnit(const Unit & unit, const int & sign);
+    void                    updateHPSums(const Unit & unit, const HealthType & hpBefore);
+    void                    updateDeadlock();
+    void                    addUnitToGrid(const IDType & player, const UnitCountType & unitIndex);
+
+    // add or remove a unit's contribution to the running hash values
+    void                    addUnitHash(const Unit & unit);
+    void                    removeUnitHash(const Unit & unit);
+    void                    updateTimeHashScale();
 
 public:
 
@@ -57,6 +99,13 @@ public:
     const size_t            prevNumUnits(const IDType & player)                                     const;
     const size_t            numNeutralUnits()                                                       const;
     const size_t            closestEnemyUnitDistance(const Unit & unit)                             const;
+    const size_t            getClosestEnemyUnits(const IDType & player, const IDType & unitIndex, const size_t & k, IDType * unitIndices) const;
+    void                    getAttackTargets(const IDType & player, const IDType & unitIndex, UnitMask & targets) const;
+    const size_t            getEnemyUnitsInRange(const IDType & player, const IDType & unitIndex, const PositionType & range, IDType * unitIndices) const;
+
+    // spatial index over unit positions used by the closest unit queries, off by default
+    void                    enableUnitGrid();
+    const bool              usingUnitGrid()                                                         const;
 
     // Unit functions
     void                    sortUnits();
@@ -73,6 +122,7 @@ public:
     const Unit &            getClosestOurUnit(const IDType & player, const IDType & unitIndex);
     const Unit &            getUnitDirect(const IDType & player, const IDType & unit)               const;
     const Unit &            getNeutralUnit(const size_t & u)                                        const;
+    const UnitArrays &      getUnitArrays()                                                         const;
     
     // game time functions
     void                    setTime(const TimeType & time);
@@ -98,7 +148,10 @@ public:
 
     // move related functions
     void                    generateMoves(MoveArray & moves, const IDType & playerIndex)            const;
+    const PositionType      getMoveDistance(const Unit & unit)                                      const;
+    const bool              canMoveTo(const Unit & unit, const Position & dest)                     const;
     void                    makeMoves(const std::vector<UnitAction> & moves);
+    void                    makeMoves(const UnitAction * moves, const size_t & numMoves);
     const int &             getNumMovements(const IDType & player)                                  const;
     const IDType            whoCanMove()                                                            const;
     const bool              bothCanMove()                                                           const;
@@ -111,6 +164,10 @@ public:
 
     // hashing functions
     const HashType          calculateHash(const size_t & hashNum)                                   const;
+    const HashType          recalculateHash(const size_t & hashNum)                                 const;
+
+    // playouts which never look at the hash can switch off its incremental updates
+    void                    setHashing(const bool & hashing);
 
     // state i/o functions
     void                    print(int indent = 0) const;
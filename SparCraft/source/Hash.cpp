@@ -17,6 +17,11 @@ const HashType Hash::HashValues::positionHash(const IDType & player, const Posit
 	return hash32shift(hash32shift(unitPositionHash[player] ^ x) ^ y);
 }
 
+const HashType Hash::HashValues::getPreviousPositionHash(const IDType & player, const PositionType & x, const PositionType & y) const
+{
+	return hash32shift(hash32shift(previousPositionHash[player] ^ x) ^ y);
+}
+
 Hash::HashValues::HashValues(int seed)
 {
 	RandomInt rand(std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), seed);
@@ -39,9 +44,71 @@ Hash::HashValues::HashValues(int seed)
 		timeCanMoveHash[p]		= rand.nextInt();
 		unitTypeHash[p]			= rand.nextInt();
 		currentHPHash[p]		= rand.nextInt();
+		previousPositionHash[p]	= rand.nextInt();
+
+		for (size_t u(0); u<Num_Unit_IDs; ++u)
+		{
+			unitIDHash[p][u]	= rand.nextInt();
+			attackTimeKey[p][u]	= rand.nextInt();
+			moveTimeKey[p][u]	= rand.nextInt();
+			actionTimeKey[p][u]	= rand.nextInt();
+		}
+	}
+
+	// the time base must be odd to be invertible mod 2^32, 3 or 5 mod 8 gives it the maximum order 2^30
+	HashType base = ((HashType)rand.nextInt() & ~(HashType)7) | 3;
+
+	// inverse of the base mod 2^32 by newton iteration, each step doubles the number of correct bits
+	HashType baseInverse = base;
+	for (size_t i(0); i<5; ++i)
+	{
+		baseInverse *= 2 - base * baseInverse;
+	}
+
+	for (size_t b(0); b<3; ++b)
+	{
+		timePowers[b][0] = 1;
+		timePowersInverse[b][0] = 1;
+
+		for (size_t i(1); i<256; ++i)
+		{
+			timePowers[b][i] = timePowers[b][i-1] * base;
+			timePowersInverse[b][i] = timePowersInverse[b][i-1] * baseInverse;
+		}
+
+		// the next byte's powers step by base^256
+		base = timePowers[b][255] * base;
+		baseInverse = timePowersInverse[b][255] * baseInverse;
 	}
 }
 
+const HashType Hash::HashValues::timePower(const TimeType & time) const
+{
+	const HashType t((HashType)time);
+	return timePowers[0][t & 0xFF] * timePowers[1][(t >> 8) & 0xFF] * timePowers[2][(t >> 16) & 0xFF];
+}
+
+const HashType Hash::HashValues::timePowerInverse(const TimeType & time) const
+{
+	const HashType t((HashType)time);
+	return timePowersInverse[0][t & 0xFF] * timePowersInverse[1][(t >> 8) & 0xFF] * timePowersInverse[2][(t >> 16) & 0xFF];
+}
+
+const HashType Hash::HashValues::getAttackTimeHash(const size_t & player, const size_t & unitID, const TimeType & time) const
+{
+	return attackTimeKey[player][unitID] * timePower(time);
+}
+
+const HashType Hash::HashValues::getMoveTimeHash(const size_t & player, const size_t & unitID, const TimeType & time) const
+{
+	return moveTimeKey[player][unitID] * timePower(time);
+}
+
+const HashType Hash::HashValues::getActionTimeHash(const size_t & player, const size_t & unitID, const TimeType & time) const
+{
+	return actionTimeKey[player][unitID] * timePower(time);
+}
+
 const HashType Hash::HashValues::getAttackHash (const size_t & player, const size_t & value) const		
 { 
 	return hash32shift(timeCanAttackHash[player] ^ value); 
@@ -51,6 +118,7 @@ const HashType Hash::HashValues::getAttackHash (const size_t & player, const siz
 const HashType Hash::HashValues::getMoveHash		(const size_t & player, const size_t & value) const		{ return hash32shift(timeCanMoveHash[player] ^ value); }
 const HashType Hash::HashValues::getUnitTypeHash	(const size_t & player, const size_t & value) const		{ return hash32shift(unitTypeHash[player] ^ value); }
 const HashType Hash::HashValues::getCurrentHPHash	(const size_t & player, const size_t & value) const		{ return hash32shift(currentHPHash[player] ^ value); }
+const HashType Hash::HashValues::getUnitIDHash		(const size_t & player, const size_t & unitID) const	{ return unitIDHash[player][unitID]; }
 
 //Robert Jenkins' 32 bit integer hash function
 const size_t Hash::jenkinsHash( size_t a)
@@ -11,13 +11,26 @@ namespace Hash
 {
 	typedef std::vector<HashType> HashVec;
 
+	// number of distinct unit ID values, all 256 8 bit IDs unless a large unit capacity needs more
+	const size_t Num_Unit_IDs = (Constants::Num_Players * Constants::Max_Units > 256) ? Constants::Num_Players * Constants::Max_Units : 256;
+
 	class HashValues
 	{
 		HashType	unitPositionHash[Constants::Num_Players];
+		HashType	previousPositionHash[Constants::Num_Players];
 		HashType	timeCanAttackHash[Constants::Num_Players];
 		HashType	timeCanMoveHash[Constants::Num_Players];
 		HashType	unitTypeHash[Constants::Num_Players];
 		HashType	currentHPHash[Constants::Num_Players];
+		HashType	unitIDHash[Constants::Num_Players][Num_Unit_IDs];
+
+		// Unit times are hashed as key * B^time so that the hash of a whole state can be 
+		// shifted to be relative to the current game time by multiplying with B^-currentTime
+		HashType	attackTimeKey[Constants::Num_Players][Num_Unit_IDs];
+		HashType	moveTimeKey[Constants::Num_Players][Num_Unit_IDs];
+		HashType	actionTimeKey[Constants::Num_Players][Num_Unit_IDs];
+		HashType	timePowers[3][256];			// B^t for each byte of a 24 bit time t
+		HashType	timePowersInverse[3][256];	// B^-t for each byte of a 24 bit time t
 
 	public:
 
@@ -27,7 +40,16 @@ namespace Hash
 		const HashType getMoveHash			(const size_t & player, const size_t & value) const;
 		const HashType getUnitTypeHash		(const size_t & player, const size_t & value) const;
 		const HashType getCurrentHPHash		(const size_t & player, const size_t & value) const;
+		const HashType getUnitIDHash		(const size_t & player, const size_t & unitID) const;
 		const HashType positionHash			(const IDType & player, const PositionType & x, const PositionType & y) const;
+		const HashType getPreviousPositionHash(const IDType & player, const PositionType & x, const PositionType & y) const;
+
+		// time hashes are summed, not xor-ed, see GameState::calculateHash
+		const HashType getAttackTimeHash	(const size_t & player, const size_t & unitID, const TimeType & time) const;
+		const HashType getMoveTimeHash		(const size_t & player, const size_t & unitID, const TimeType & time) const;
+		const HashType getActionTimeHash	(const size_t & player, const size_t & unitID, const TimeType & time) const;
+		const HashType timePower			(const TimeType & time) const;
+		const HashType timePowerInverse		(const TimeType & time) const;
 	};
 
 	// some data storage
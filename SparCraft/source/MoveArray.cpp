@@ -1,7 +1,49 @@
 #include "MoveArray.h"
 
+#include <algorithm>
+#include <boost/random/uniform_int_distribution.hpp>
+
 using namespace SparCraft;
 
+namespace
+{
+    // random_shuffle generator which draws from a boost generator instead of std::rand
+    class ShuffleRandom
+    {
+        boost::random::mt19937 & _gen;
+
+    public:
+
+        ShuffleRandom(boost::random::mt19937 & gen)
+            : _gen(gen)
+        {
+        }
+
+        ptrdiff_t operator () (ptrdiff_t n)
+        {
+            return boost::random::uniform_int_distribution<ptrdiff_t>(0, n - 1)(_gen);
+        }
+    };
+
+    // orders move indices by descending score
+    class MoveScoreCompare
+    {
+        const int * _scores;
+
+    public:
+
+        MoveScoreCompare(const int * scores)
+            : _scores(scores)
+        {
+        }
+
+        const bool operator () (const size_t & m1, const size_t & m2) const
+        {
+            return _scores[m1] > _scores[m2];
+        }
+    };
+}
+
 MoveArray::MoveArray(const size_t maxUnits) 
 	: _numUnits(0)
 	, _maxUnits(Constants::Max_Units)
@@ -28,7 +70,7 @@ void MoveArray::clear()
 // shuffle the MOVE unit actions to prevent bias in experiments
 // this function assumes that all MOVE actions are contiguous in the moves array
 // this should be the case unless you change the move generation ordering
-void MoveArray::shuffleMoveActions()
+void MoveArray::shuffleMoveActions(boost::random::mt19937 * gen)
 {
     // for each unit
     for (size_t u(0); u<numUnits(); ++u)
@@ -67,16 +109,49 @@ void MoveArray::shuffleMoveActions()
         // shuffle the movement actions for this unit
         if (moveEnd != -1 && moveBegin != -1 && moveEnd != moveBegin)
         {
-            std::random_shuffle(&_moves[u][moveBegin], &_moves[u][moveEnd]);
+            if (gen)
+            {
+                ShuffleRandom random(*gen);
+                std::random_shuffle(&_moves[u][moveBegin], &_moves[u][moveEnd], random);
+            }
+            else
+            {
+                std::random_shuffle(&_moves[u][moveBegin], &_moves[u][moveEnd]);
+            }
             resetMoveIterator();
         }
     }
 }
 
+void MoveArray::sortMoves(const size_t & unit, const int * scores)
+{
+    size_t      order[Constants::Max_Moves];
+    UnitAction  sorted[Constants::Max_Moves];
+
+    for (size_t m(0); m<numMoves(unit); ++m)
+    {
+        order[m] = m;
+    }
+
+    std::stable_sort(order, order + numMoves(unit), MoveScoreCompare(scores));
+
+    for (size_t m(0); m<numMoves(unit); ++m)
+    {
+        sorted[m] = _moves[unit][order[m]];
+    }
+
+    for (size_t m(0); m<numMoves(unit); ++m)
+    {
+        _moves[unit][m] = sorted[m];
+    }
+
+    resetMoveIterator();
+}
+
 // returns a given move from a unit
 const UnitAction & MoveArray::getMove(const size_t & unit, const size_t & move) const
 {
-    assert(_moves[unit][(size_t)move].unit() != 255);
+    assert(_moves[unit][(size_t)move].unit() != Constants::No_ID);
 
     return _moves[unit][(size_t)move];
 }
@@ -168,7 +243,7 @@ bool MoveArray::validateMoves()
 		{
 			const UnitAction & move(getMove(u, m));
 
-			if (move.unit() > 200)
+			if (move.unit() >= Constants::Max_Units)
 			{
 				printf("Unit Move Incorrect! Something will be wrong\n");
 				return false;
@@ -5,6 +5,8 @@
 #include "Unit.h"
 #include "UnitAction.hpp"
 
+#include <boost/random/mersenne_twister.hpp>
+
 namespace SparCraft
 {
 class MoveArray
@@ -58,7 +60,11 @@ public:
 
 	void addUnit();
 
-    void shuffleMoveActions();
+    // shuffles with the given generator, or with std::rand if it is NULL
+    void shuffleMoveActions(boost::random::mt19937 * gen = NULL);
+
+    // puts a unit's moves in order of descending score, moves with equal scores keep their order
+    void sortMoves(const size_t & unit, const int * scores);
 
 	const size_t & numUnits()						const;
 	const size_t & numUnitsInTuple()				const;
@@ -3,6 +3,7 @@
 using namespace SparCraft;
 
 PlayerProperties PlayerProperties::props[2];
+size_t PlayerProperties::numChanges(0);
 
 PlayerProperties::PlayerProperties()
 {
@@ -19,8 +20,15 @@ PlayerProperties & PlayerProperties::Get(const size_t & playerID)
     return props[playerID]; 
 }
 
+const size_t & PlayerProperties::NumChanges()
+{ 
+    return numChanges; 
+}
+
 void PlayerProperties::Reset()
 {
+	numChanges++;
+
 	for(int i(0); i<NUM_UPGRADES; ++i)
 	{
 		upgradeLevel[i] = 0;
@@ -38,6 +46,7 @@ void PlayerProperties::SetUpgradeLevel(BWAPI::UpgradeType upgrade, int level)
 	assert(upgrade != BWAPI::UpgradeTypes::Unknown);
 	assert(level >= 0 && level <= upgrade.maxRepeats());
 	upgradeLevel[upgrade.getID()] = level;
+	numChanges++;
 }
 
 void PlayerProperties::SetResearched(BWAPI::TechType tech, bool researched)
@@ -45,10 +54,13 @@ void PlayerProperties::SetResearched(BWAPI::TechType tech, bool researched)
 	assert(tech != BWAPI::TechTypes::None); 
 	assert(tech != BWAPI::TechTypes::Unknown); 
 	hasResearched[tech.getID()] = researched;
+	numChanges++;
 }
 
 void PlayerProperties::Capture(const BWAPI::Player & player)
 {
+	numChanges++;
+
 	for(int i(0); i<NUM_UPGRADES; ++i)
 	{
 		upgradeLevel[i] = player.getUpgradeLevel(i);
@@ -14,6 +14,7 @@ class PlayerProperties
 	bool		hasResearched[NUM_TECHS];
 
     static      PlayerProperties    props[2];
+    static      size_t              numChanges;
 
 public:
 				PlayerProperties();
@@ -29,6 +30,9 @@ public:
 	void		Capture(const BWAPI::Player & player);
 
     static      PlayerProperties & Get(const size_t & playerID);
+
+    // incremented whenever the properties of any player change, tables built from them check this
+    static      const size_t &      NumChanges();
 };
 
 class PlayerWeapon
@@ -39,6 +39,7 @@ void Player_AlphaBeta::setParameters(AlphaBetaSearchParameters & p)
 void Player_AlphaBeta::setTranspositionTable(TTPtr table)
 {
 	TT = table;
+	alphaBeta->setTranspositionTable(TT);
 }
 
 void Player_AlphaBeta::getMoves(GameState & state, const MoveArray & moves, std::vector<UnitAction> & moveVec)
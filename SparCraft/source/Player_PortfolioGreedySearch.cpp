@@ -8,21 +8,25 @@ Player_PortfolioGreedySearch::Player_PortfolioGreedySearch (const IDType & playe
 	_iterations = 1;
     _responses = 0;
 	_seed = PlayerModels::NOKDPS;
+    _timeLimit = 0;
+    _numThreads = 1;
+    _search = boost::shared_ptr<PortfolioGreedySearch>(new PortfolioGreedySearch(_playerID, _seed, _iterations, _responses, _timeLimit, _numThreads));
 }
 
-Player_PortfolioGreedySearch::Player_PortfolioGreedySearch (const IDType & playerID, const IDType & seed, const size_t & iter, const size_t & responses, const size_t & timeLimit)
+Player_PortfolioGreedySearch::Player_PortfolioGreedySearch (const IDType & playerID, const IDType & seed, const size_t & iter, const size_t & responses, const size_t & timeLimit, const size_t & numThreads)
 {
 	_playerID = playerID;
 	_iterations = iter;
     _responses = responses;
 	_seed = seed;
     _timeLimit = timeLimit;
+    _numThreads = numThreads;
+    _search = boost::shared_ptr<PortfolioGreedySearch>(new PortfolioGreedySearch(_playerID, _seed, _iterations, _responses, _timeLimit, _numThreads));
 }
 
 void Player_PortfolioGreedySearch::getMoves(GameState & state, const MoveArray & moves, std::vector<UnitAction> & moveVec)
 {
     moveVec.clear();
-	PortfolioGreedySearch pgs(_playerID, _seed, _iterations, _responses, _timeLimit);
 
-	moveVec = pgs.search(_playerID, state);
+	moveVec = _search->search(_playerID, state);
 }
@@ -6,15 +6,19 @@
 
 namespace SparCraft
 {
+class PortfolioGreedySearch;
+
 class Player_PortfolioGreedySearch : public Player
 {
 	IDType _seed;
 	size_t _iterations;
     size_t _responses;
     size_t _timeLimit;
+    size_t _numThreads;
+    boost::shared_ptr<PortfolioGreedySearch> _search;  // kept so its worker threads are started once, not on every move
 public:
 	Player_PortfolioGreedySearch (const IDType & playerID);
-    Player_PortfolioGreedySearch (const IDType & playerID, const IDType & seed, const size_t & iter, const size_t & responses, const size_t & timeLimit);
+    Player_PortfolioGreedySearch (const IDType & playerID, const IDType & seed, const size_t & iter, const size_t & responses, const size_t & timeLimit, const size_t & numThreads = 1);
 	void getMoves(GameState & state, const MoveArray & moves, std::vector<UnitAction> & moveVec);
     IDType getType() { return PlayerModels::PortfolioGreedySearch; }
 };
@@ -3,9 +3,12 @@
 using namespace SparCraft;
 
 Player_UCT::Player_UCT (const IDType & playerID, const UCTSearchParameters & params) 
+    : _hasPreviousTree(false)
 {
 	_playerID = playerID;
     _params = params;
+    _memoryPool = boost::shared_ptr<UCTMemoryPool>(new UCTMemoryPool());
+    _previousPool = boost::shared_ptr<UCTMemoryPool>(new UCTMemoryPool());
 }
 
 void Player_UCT::getMoves(GameState & state, const MoveArray & moves, std::vector<UnitAction> & moveVec)
@@ -13,9 +16,23 @@ void Player_UCT::getMoves(GameState & state, const MoveArray & moves, std::vecto
     moveVec.clear();
     
     UCTSearch uct(_params);
+    uct.setMemoryPool(_memoryPool.get());
+
+    if (_params.reuseTree() && _hasPreviousTree)
+    {
+        uct.setPreviousTree(_previousPool.get(), _previousState);
+    }
 
     uct.doSearch(state, moveVec);
     _prevResults = uct.getResults();
+
+    // the tree just searched is the previous tree of the next search, which builds its tree in the other pool
+    if (_params.reuseTree())
+    {
+        std::swap(_memoryPool, _previousPool);
+        _previousState = state;
+        _hasPreviousTree = true;
+    }
 }
 
 UCTSearchParameters & Player_UCT::getParams()
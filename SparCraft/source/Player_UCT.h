@@ -12,6 +12,10 @@ class Player_UCT : public Player
 {
     UCTSearchParameters     _params;
     UCTSearchResults        _prevResults;
+    boost::shared_ptr<UCTMemoryPool> _memoryPool;   // kept so every search reuses the memory of the last one
+    boost::shared_ptr<UCTMemoryPool> _previousPool; // the tree of the last search if the tree is reused
+    GameState               _previousState;
+    bool                    _hasPreviousTree;
 public:
     Player_UCT (const IDType & playerID, const UCTSearchParameters & params);
 	void getMoves(GameState & state, const MoveArray & moves, std::vector<UnitAction> & moveVec);
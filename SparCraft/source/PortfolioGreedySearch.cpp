@@ -1,17 +1,47 @@
 #include "PortfolioGreedySearch.h"
+#include <boost/bind.hpp>
+#include <algorithm>
 
 using namespace SparCraft;
 
-PortfolioGreedySearch::PortfolioGreedySearch(const IDType & player, const IDType & enemyScript, const size_t & iter, const size_t & responses, const size_t & timeLimit)
+PortfolioGreedySearch::PortfolioGreedySearch(const IDType & player, const IDType & enemyScript, const size_t & iter, const size_t & responses, const size_t & timeLimit, const size_t & numThreads)
 	: _player(player)
 	, _enemyScript(enemyScript)
 	, _iterations(iter)
     , _responses(responses)
     , _totalEvals(0)
     , _timeLimit(timeLimit)
+    , _numThreads(std::max(numThreads, (size_t)1))
+    , _batch(0)
+    , _busyWorkers(0)
+    , _stopWorkers(false)
+    , _batchPlayer(player)
+    , _batchState(NULL)
+    , _batchScripts(NULL)
+    , _batchTimer(NULL)
+    , _nextCandidate(0)
 {
 	_playerScriptPortfolio.push_back(PlayerModels::NOKDPS);
 	_playerScriptPortfolio.push_back(PlayerModels::KiterDPS);
+
+    if (_numThreads > 1)
+    {
+        for (size_t t(0); t<_numThreads; ++t)
+        {
+            _workers.create_thread(boost::bind(&PortfolioGreedySearch::workerLoop, this));
+        }
+    }
+}
+
+PortfolioGreedySearch::~PortfolioGreedySearch()
+{
+    {
+        boost::mutex::scoped_lock lock(_workerMutex);
+        _stopWorkers = true;
+        _workReady.notify_all();
+    }
+
+    _workers.join_all();
 }
 
 std::vector<UnitAction> PortfolioGreedySearch::search(const IDType & player, const GameState & state)
@@ -62,6 +92,12 @@ std::vector<UnitAction> PortfolioGreedySearch::search(const IDType & player, con
 
 void PortfolioGreedySearch::doPortfolioSearch(const IDType & player, const GameState & state, UnitScriptData & currentScriptData)
 {
+    if (_numThreads > 1)
+    {
+        doParallelPortfolioSearch(player, state, currentScriptData);
+        return;
+    }
+
     Timer t;
     t.start();
 
@@ -107,6 +143,209 @@ void PortfolioGreedySearch::doPortfolioSearch(const IDType & player, const GameS
     }   
 }
 
+// The parallel improvement step makes the same choices as the serial one. The serial step tries
+// the scripts of one unit at a time, with the units before it on the scripts just chosen for them
+// and the units after it on their current ones. So every try it makes for a window of consecutive
+// units is one of the assignments of portfolio scripts to those units, the others keeping theirs.
+// All of those are played out at once on the worker threads, as many units to a window as there
+// are threads for the assignments, and the serial choices are then made from their scores. Units
+// whose tries didn't all finish in time keep their scripts
+void PortfolioGreedySearch::doParallelPortfolioSearch(const IDType & player, const GameState & state, UnitScriptData & currentScriptData)
+{
+    Timer t;
+    t.start();
+
+    const size_t numScripts(_playerScriptPortfolio.size());
+    std::vector<size_t> scriptIndex;
+
+    for (size_t i(0); i<_iterations; ++i)
+    {
+        size_t unitIndex(0);
+
+        while (unitIndex < state.numUnits(player))
+        {
+            if (_timeLimit > 0 && t.getElapsedTimeInMilliSec() > _timeLimit)
+            {
+                return;
+            }
+
+            // the units after the first of the window are played out on their current script in the
+            // tries of the units before them, so that has to be one of the portfolio
+            _windowUnits.clear();
+            scriptIndex.clear();
+            size_t numAssignments(1);
+
+            while ((unitIndex + _windowUnits.size() < state.numUnits(player)) && (_windowUnits.empty() || (numAssignments * numScripts <= _numThreads)))
+            {
+                const size_t u(unitIndex + _windowUnits.size());
+                const IDType & script(currentScriptData.getUnitScript(state.getUnit(player, u)));
+                const size_t index(std::find(_playerScriptPortfolio.begin(), _playerScriptPortfolio.end(), script) - _playerScriptPortfolio.begin());
+
+                if (!_windowUnits.empty() && (index == numScripts))
+                {
+                    break;
+                }
+
+                _windowUnits.push_back(u);
+                scriptIndex.push_back(index);
+                numAssignments *= numScripts;
+            }
+
+            Candidate candidate;
+            candidate.evaluated = false;
+            _candidates.assign(numAssignments, candidate);
+            _nextCandidate = 0;
+
+            _batchPlayer = player;
+            _batchState = &state;
+            _batchScripts = &currentScriptData;
+            _batchTimer = &t;
+
+            runCandidates();
+
+            // make the choices of the serial search, unit by unit, from the played out assignments
+            for (size_t w(0); w<_windowUnits.size(); ++w)
+            {
+                size_t bestScriptIndex(0);
+                size_t bestAssignment(0);
+
+                for (size_t sIndex(0); sIndex<numScripts; ++sIndex)
+                {
+                    scriptIndex[w] = sIndex;
+
+                    size_t assignment(0);
+                    for (size_t v(_windowUnits.size()); v > 0; --v)
+                    {
+                        assignment = assignment * numScripts + scriptIndex[v-1];
+                    }
+
+                    if (!_candidates[assignment].evaluated)
+                    {
+                        return;
+                    }
+
+                    if (sIndex == 0 || _candidates[assignment].score > _candidates[bestAssignment].score)
+                    {
+                        bestScriptIndex = sIndex;
+                        bestAssignment = assignment;
+                    }
+                }
+
+                scriptIndex[w] = bestScriptIndex;
+                currentScriptData.setUnitScript(state.getUnit(player, _windowUnits[w]), _playerScriptPortfolio[bestScriptIndex]);
+            }
+
+            unitIndex += _windowUnits.size();
+        }
+    }
+}
+
+// hands the candidates to the workers and waits until they are all played out or time is up
+void PortfolioGreedySearch::runCandidates()
+{
+    boost::mutex::scoped_lock lock(_workerMutex);
+
+    _busyWorkers = _numThreads;
+    _batch++;
+    _workReady.notify_all();
+
+    while (_busyWorkers > 0)
+    {
+        _workDone.wait(lock);
+    }
+}
+
+// a worker waits for each batch of candidates and plays them out on a copy of the current scripts
+// of its own, which also has its own script players
+void PortfolioGreedySearch::workerLoop()
+{
+    UnitScriptData scriptData;
+    size_t batch(0);
+
+    while (true)
+    {
+        {
+            boost::mutex::scoped_lock lock(_workerMutex);
+
+            while (!_stopWorkers && (_batch == batch))
+            {
+                _workReady.wait(lock);
+            }
+
+            if (_stopWorkers)
+            {
+                return;
+            }
+
+            batch = _batch;
+        }
+
+        for (IDType p(0); p<Constants::Num_Players; ++p)
+        {
+            for (size_t u(0); u<_batchState->numUnits(p); ++u)
+            {
+                const Unit & unit(_batchState->getUnit(p, u));
+                scriptData.setUnitScript(unit, _batchScripts->getUnitScript(unit));
+            }
+        }
+
+        evalCandidates(scriptData);
+
+        boost::mutex::scoped_lock lock(_workerMutex);
+
+        if (--_busyWorkers == 0)
+        {
+            _workDone.notify_one();
+        }
+    }
+}
+
+// take candidates off the queue until it is empty or time is up, and play each out
+void PortfolioGreedySearch::evalCandidates(UnitScriptData & scriptData)
+{
+    const size_t numScripts(_playerScriptPortfolio.size());
+    Timer timer(*_batchTimer);
+    size_t numEvals(0);
+
+    while (true)
+    {
+        size_t c(0);
+
+        {
+            boost::mutex::scoped_lock lock(_workerMutex);
+
+            if (_nextCandidate >= _candidates.size())
+            {
+                break;
+            }
+
+            c = _nextCandidate++;
+        }
+
+        if (_timeLimit > 0 && timer.getElapsedTimeInMilliSec() > _timeLimit)
+        {
+            break;
+        }
+
+        size_t assignment(c);
+        for (size_t w(0); w<_windowUnits.size(); ++w)
+        {
+            scriptData.setUnitScript(_batchState->getUnit(_batchPlayer, _windowUnits[w]), _playerScriptPortfolio[assignment % numScripts]);
+            assignment /= numScripts;
+        }
+
+        ScriptPlayout playout(*_batchState, scriptData, 100);
+        playout.play();
+
+        _candidates[c].score = playout.getState().eval(_batchPlayer, SparCraft::EvaluationMethods::LTD2);
+        _candidates[c].evaluated = true;
+        numEvals++;
+    }
+
+    boost::mutex::scoped_lock lock(_workerMutex);
+    _totalEvals += numEvals;
+}
+
 IDType PortfolioGreedySearch::calculateInitialSeed(const IDType & player, const GameState & state)
 {
     IDType bestScript;
@@ -147,13 +386,13 @@ StateEvalScore PortfolioGreedySearch::eval(const IDType & player, const GameStat
 {
     const IDType enemyPlayer(state.getEnemy(player));
 
-	Game g(state, 100);
+	ScriptPlayout playout(state, playerScriptsChosen, 100);
 
-    g.playIndividualScripts(playerScriptsChosen);
+    playout.play();
 
     _totalEvals++;
 
-	return g.getState().eval(player, SparCraft::EvaluationMethods::LTD2);
+	return playout.getState().eval(player, SparCraft::EvaluationMethods::LTD2);
 }
 
 void  PortfolioGreedySearch::setAllScripts(const IDType & player, const GameState & state, UnitScriptData & data, const IDType & script)
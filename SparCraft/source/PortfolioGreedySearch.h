@@ -6,7 +6,12 @@
 #include "Game.h"
 #include "UnitAction.hpp"
 #include "UnitScriptData.h"
+#include "ScriptPlayout.h"
+#include "Timer.h"
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 
 namespace SparCraft
 {
@@ -16,6 +21,14 @@ typedef	boost::shared_ptr<Player> PlayerPtr;
 class PortfolioGreedySearch
 {
 protected:
+
+    // one playout of a parallel improvement step, with the units of the window on the scripts of
+    // one assignment, the candidate's index read as a number in base portfolio size
+    struct Candidate
+    {
+        StateEvalScore  score;
+        bool            evaluated;
+    };
 	
 	const IDType				_player;
 	const IDType				_enemyScript;
@@ -24,8 +37,34 @@ protected:
 	std::vector<IDType>			_playerScriptPortfolio;
     size_t                      _totalEvals;
     size_t                      _timeLimit;
+    size_t                      _numThreads;
+
+    // the worker threads of the parallel search, started with it and kept until it is destroyed
+    boost::thread_group         _workers;
+    boost::mutex                _workerMutex;
+    boost::condition_variable   _workReady;
+    boost::condition_variable   _workDone;
+    size_t                      _batch;             // incremented to hand the workers new candidates
+    size_t                      _busyWorkers;
+    bool                        _stopWorkers;
+
+    // the candidates the workers are playing out and what they need for it
+    IDType                      _batchPlayer;
+    const GameState *           _batchState;
+    const UnitScriptData *      _batchScripts;
+    Timer *                     _batchTimer;
+    std::vector<size_t>         _windowUnits;
+    std::vector<Candidate>      _candidates;
+    size_t                      _nextCandidate;
+
+    PortfolioGreedySearch(const PortfolioGreedySearch & rhs);
+    PortfolioGreedySearch & operator = (const PortfolioGreedySearch & rhs);
 
     void                doPortfolioSearch(const IDType & player, const GameState & state, UnitScriptData & currentData);
+    void                doParallelPortfolioSearch(const IDType & player, const GameState & state, UnitScriptData & currentData);
+    void                runCandidates();
+    void                workerLoop();
+    void                evalCandidates(UnitScriptData & scriptData);
     std::vector<UnitAction>   getMoveVec(const IDType & player, const GameState & state, const std::vector<IDType> & playerScripts);
     StateEvalScore      eval(const IDType & player, const GameState & state, UnitScriptData & playerScriptsChosen);
     IDType              calculateInitialSeed(const IDType & player, const GameState & state);
@@ -33,7 +72,9 @@ protected:
 
 public:
 	
-	PortfolioGreedySearch(const IDType & player, const IDType & enemyScript, const size_t & iter, const size_t & responses, const size_t & timeLimit);
+	PortfolioGreedySearch(const IDType & player, const IDType & enemyScript, const size_t & iter, const size_t & responses, const size_t & timeLimit, const size_t & numThreads = 1);
+    ~PortfolioGreedySearch();
+
     std::vector<UnitAction>   search(const IDType & player, const GameState & state);
 };
 
@@ -0,0 +1,350 @@
+#include "ScriptPlayout.h"
+
+using namespace SparCraft;
+
+ScriptPlayout::ScriptPlayout(const GameState & state, const IDType & p1Script, const IDType & p2Script, const size_t & moveLimit)
+    : _state(state)
+    , _scriptData(NULL)
+    , _supported(true)
+    , _moveLimit(moveLimit)
+    , _maxRounds(moveLimit)
+    , _rounds(0)
+{
+    _playerScript[Players::Player_One] = p1Script;
+    _playerScript[Players::Player_Two] = p2Script;
+
+    for (IDType p(0); p<Constants::Num_Players; ++p)
+    {
+        _runsNOKDPS[p] = (_playerScript[p] == PlayerModels::NOKDPS);
+        _supported = _supported && supports(_playerScript[p]);
+    }
+
+    _state.setHashing(false);
+    checkUnits();
+}
+
+ScriptPlayout::ScriptPlayout(const GameState & state, UnitScriptData & scriptData, const size_t & moveLimit)
+    : _state(state)
+    , _scriptData(&scriptData)
+    , _supported(true)
+    , _moveLimit(moveLimit)
+    , _maxRounds(moveLimit ? moveLimit + 1 : 0)
+    , _rounds(0)
+{
+    for (IDType p(0); p<Constants::Num_Players; ++p)
+    {
+        _playerScript[p] = PlayerModels::None;
+        _runsNOKDPS[p] = false;
+
+        // every script of the player computes its moves each turn, so NOKDPS keeps track of the
+        // damage assigned by all units even if none of them ends up running it
+        for (size_t s(0); s<scriptData.getNumScripts(p); ++s)
+        {
+            const IDType script(scriptData.getScript(p, s));
+
+            _runsNOKDPS[p] = _runsNOKDPS[p] || (script == PlayerModels::NOKDPS);
+            _supported = _supported && supports(script);
+        }
+
+        for (size_t u(0); u<_state.numUnits(p); ++u)
+        {
+            const Unit & unit(_state.getUnit(p, u));
+
+            if (unit.ID() >= Hash::Num_Unit_IDs)
+            {
+                _supported = false;
+                continue;
+            }
+
+            _unitScript[p][unit.ID()] = scriptData.getUnitScript(unit);
+        }
+    }
+
+    _state.setHashing(false);
+    checkUnits();
+}
+
+const bool ScriptPlayout::supports(const IDType & script)
+{
+    return script == PlayerModels::NOKDPS
+        || script == PlayerModels::AttackClosest
+        || script == PlayerModels::Kiter
+        || script == PlayerModels::KiterDPS;
+}
+
+// healers get HEAL moves and pick their closest unit among their own, which the playout doesn't do
+void ScriptPlayout::checkUnits()
+{
+    for (IDType p(0); p<Constants::Num_Players; ++p)
+    {
+        for (size_t u(0); u<_state.numUnits(p); ++u)
+        {
+            if (_state.getUnit(p, u).canHeal())
+            {
+                _supported = false;
+            }
+        }
+    }
+}
+
+// the same loop as Game::play
+void ScriptPlayout::play()
+{
+    if (!_supported)
+    {
+        playGame();
+        return;
+    }
+
+    while (!_state.isTerminal())
+    {
+        if (_maxRounds && _rounds >= _maxRounds)
+        {
+            break;
+        }
+
+        const IDType whoCanMove(_state.whoCanMove());
+        const IDType playerToMove((whoCanMove == Players::Player_Both) ? Players::Player_One : whoCanMove);
+        const IDType enemyPlayer(_state.getEnemy(playerToMove));
+
+        getMoves(playerToMove, _moves[playerToMove]);
+
+        // if both players can move, the other player's moves are chosen before anything is done
+        if (_state.bothCanMove())
+        {
+            getMoves(enemyPlayer, _moves[enemyPlayer]);
+            _state.makeMoves(_moves[enemyPlayer]);
+        }
+
+        _state.makeMoves(_moves[playerToMove]);
+        _state.finishedMoving();
+        _rounds++;
+    }
+
+    _state.setHashing(true);
+}
+
+void ScriptPlayout::playGame()
+{
+    _state.setHashing(true);
+
+    if (_scriptData)
+    {
+        Game game(_state, _moveLimit);
+        game.playIndividualScripts(*_scriptData);
+
+        _state = game.getState();
+        _rounds = game.getRounds();
+    }
+    else
+    {
+        PlayerPtr p1(AllPlayers::getPlayerPtr(Players::Player_One, _playerScript[Players::Player_One]));
+        PlayerPtr p2(AllPlayers::getPlayerPtr(Players::Player_Two, _playerScript[Players::Player_Two]));
+
+        Game game(_state, p1, p2, _moveLimit);
+        game.play();
+
+        _state = game.getState();
+        _rounds = game.getRounds();
+    }
+}
+
+// the moves of the units which can move at the same time as the first, see GameState::generateMoves
+void ScriptPlayout::getMoves(const IDType & player, std::vector<UnitAction> & moves)
+{
+    moves.clear();
+
+    const UnitArrays &  arrays(_state.getUnitArrays());
+    const IDType        enemyPlayer(_state.getEnemy(player));
+    const TimeType      firstUnitMoveTime(arrays.firstTimeFree(player, 0));
+
+    if (_runsNOKDPS[player])
+    {
+        for (IDType u(0); u<_state.numUnits(enemyPlayer); ++u)
+        {
+            _hpRemaining[u] = arrays.hp(enemyPlayer, u);
+        }
+    }
+
+    for (IDType u(0); u<_state.numUnits(player); ++u)
+    {
+        if (arrays.firstTimeFree(player, u) != firstUnitMoveTime)
+        {
+            break;
+        }
+
+        moves.push_back(getMove(player, u));
+    }
+}
+
+// The action the unit's script would pick from the moves GameState::generateMoves gives it. Those
+// are, in order: an ATTACK for every target in range or a RELOAD if it can't attack yet, a MOVE
+// for every direction it can go to, or a single PASS if there is nothing else. A script which
+// finds nothing better falls back to the first of them
+const UnitAction ScriptPlayout::getMove(const IDType & player, const IDType & unitIndex)
+{
+    const Unit &        unit(_state.getUnit(player, unitIndex));
+    const IDType        enemyPlayer(_state.getEnemy(player));
+    const IDType        script(_scriptData ? _unitScript[player][unit.ID()] : _playerScript[player]);
+    const TimeType      time(_state.getTime());
+    const bool          canAttack(unit.canAttackNow());
+
+    UnitMask targets;
+    if (canAttack)
+    {
+        _state.getAttackTargets(player, unitIndex, targets);
+    }
+
+    const size_t        firstTarget(targets.next(0));
+
+    // NOKDPS: highest dpf / remaining hp, not attacking units which are already going to die
+    if (_runsNOKDPS[player])
+    {
+        bool    found(false);
+        size_t  bestTarget(0);
+        double  highestDPS(0);
+
+        for (size_t t(firstTarget); t<Constants::Max_Units; t = targets.next(t+1))
+        {
+            if (_hpRemaining[t] > 0)
+            {
+                const double dpsHPValue(_state.getUnit(enemyPlayer, t).dpf() / _hpRemaining[t]);
+
+                if (dpsHPValue > highestDPS)
+                {
+                    highestDPS = dpsHPValue;
+                    bestTarget = t;
+                    found = true;
+                }
+            }
+        }
+
+        // Player_NOKDPS takes the damage off its first move's target if every target is already dead
+        if (firstTarget < Constants::Max_Units)
+        {
+            _hpRemaining[found ? bestTarget : firstTarget] -= unit.damage();
+        }
+
+        if (found && script == PlayerModels::NOKDPS)
+        {
+            return UnitAction(unitIndex, player, UnitActionTypes::ATTACK, bestTarget);
+        }
+    }
+
+    // AttackClosest and Kiter: closest target, KiterDPS: highest dpf / hp
+    if (script != PlayerModels::NOKDPS && firstTarget < Constants::Max_Units)
+    {
+        size_t          bestTarget(firstTarget);
+        PositionType    closestDist(std::numeric_limits<PositionType>::max());
+        double          highestDPS(0);
+
+        for (size_t t(firstTarget); t<Constants::Max_Units; t = targets.next(t+1))
+        {
+            const Unit & target(_state.getUnit(enemyPlayer, t));
+
+            if (script == PlayerModels::KiterDPS)
+            {
+                const double dpsHPValue(target.dpf() / target.currentHP());
+
+                if (dpsHPValue > highestDPS)
+                {
+                    highestDPS = dpsHPValue;
+                    bestTarget = t;
+                }
+            }
+            else
+            {
+                const PositionType dist(unit.getDistanceSqToUnit(target, time));
+
+                if (dist < closestDist)
+                {
+                    closestDist = dist;
+                    bestTarget = t;
+                }
+            }
+        }
+
+        return UnitAction(unitIndex, player, UnitActionTypes::ATTACK, bestTarget);
+    }
+
+    const Unit & closestUnit(_state.getClosestEnemyUnit(player, unitIndex));
+    const bool inRange(unit.canAttackTarget(closestUnit, time));
+
+    // NOKDPS and AttackClosest wait for their next attack when the closest enemy is in range
+    const bool kites(script == PlayerModels::Kiter || script == PlayerModels::KiterDPS);
+    if (!canAttack && !kites && inRange)
+    {
+        return UnitAction(unitIndex, player, UnitActionTypes::RELOAD, 0);
+    }
+
+    // otherwise move towards the closest enemy, or away from it if a kiter is in its range
+    bool                found(false);
+    bool                anyMove(false);
+    UnitAction          firstMove;
+    UnitAction          bestMove;
+    size_t              bestDist(kites && inRange ? 0 : std::numeric_limits<size_t>::max());
+
+    if (unit.isMobile())
+    {
+        const PositionType moveDistance(_state.getMoveDistance(unit));
+
+        for (IDType d(0); d<Constants::Num_Directions; ++d)
+        {
+            const Position dest(unit.pos() + Position(moveDistance*Constants::Move_Dir[d][0], moveDistance*Constants::Move_Dir[d][1]));
+
+            if (!_state.canMoveTo(unit, dest))
+            {
+                continue;
+            }
+
+            // the scripts measure a one pixel step in the direction of the move
+            const Position  step(unit.x() + Constants::Move_Dir[d][0], unit.y() + Constants::Move_Dir[d][1]);
+            const size_t    dist(closestUnit.getDistanceSqToPosition(step, time));
+            const bool      better((kites && inRange) ? (dist > bestDist) : (dist < bestDist));
+
+            if (!anyMove)
+            {
+                firstMove = UnitAction(unitIndex, player, UnitActionTypes::MOVE, d, dest);
+                anyMove = true;
+            }
+
+            if (better)
+            {
+                bestDist = dist;
+                bestMove = UnitAction(unitIndex, player, UnitActionTypes::MOVE, d, dest);
+                found = true;
+            }
+        }
+    }
+
+    if (found)
+    {
+        return bestMove;
+    }
+
+    // the first move the unit was given
+    if (firstTarget < Constants::Max_Units)
+    {
+        return UnitAction(unitIndex, player, UnitActionTypes::ATTACK, firstTarget);
+    }
+    else if (!canAttack)
+    {
+        return UnitAction(unitIndex, player, UnitActionTypes::RELOAD, 0);
+    }
+    else if (anyMove)
+    {
+        return firstMove;
+    }
+
+    return UnitAction(unitIndex, player, UnitActionTypes::PASS, 0);
+}
+
+GameState & ScriptPlayout::getState()
+{
+    return _state;
+}
+
+const size_t ScriptPlayout::getRounds() const
+{
+    return _rounds;
+}
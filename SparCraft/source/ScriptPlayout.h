@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Common.h"
+#include "GameState.h"
+#include "Game.h"
+#include "UnitScriptData.h"
+#include "UnitAction.hpp"
+
+namespace SparCraft
+{
+
+// Plays a state out with fixed scripts exactly like Game::play and Game::playIndividualScripts,
+// but picks every unit's action straight from the state instead of generating a MoveArray for a
+// Player to scan. Only the parts of the move list a script looks at are computed: attack targets
+// come from the target kernel and the closest enemy is only searched for units which don't attack.
+// Handles NOKDPS, AttackClosest, Kiter and KiterDPS, any other script or a state with healers is
+// played out by a Game instead so the result is always the same
+class ScriptPlayout
+{
+    GameState                   _state;
+    UnitScriptData *            _scriptData;
+    IDType                      _playerScript[Constants::Num_Players];
+    IDType                      _unitScript[Constants::Num_Players][Hash::Num_Unit_IDs];
+    bool                        _runsNOKDPS[Constants::Num_Players];
+    bool                        _supported;
+    size_t                      _moveLimit;
+    size_t                      _maxRounds;
+    size_t                      _rounds;
+
+    std::vector<UnitAction>     _moves[Constants::Num_Players];
+    Array<int, Constants::Max_Units> _hpRemaining;
+
+    void                        checkUnits();
+    void                        playGame();
+    void                        getMoves(const IDType & player, std::vector<UnitAction> & moves);
+    const UnitAction            getMove(const IDType & player, const IDType & unitIndex);
+
+public:
+
+    // every unit of a player runs that player's script, like Game::play
+    ScriptPlayout(const GameState & state, const IDType & p1Script, const IDType & p2Script, const size_t & moveLimit);
+
+    // every unit runs its own script, like Game::playIndividualScripts
+    ScriptPlayout(const GameState & state, UnitScriptData & scriptData, const size_t & moveLimit);
+
+    static const bool           supports(const IDType & script);
+
+    void                        play();
+    GameState &                 getState();
+    const size_t                getRounds() const;
+};
+
+}
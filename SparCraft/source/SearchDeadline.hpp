@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Common.h"
+#include "Timer.h"
+
+#include <boost/atomic.hpp>
+
+namespace SparCraft
+{
+    class SearchDeadline;
+}
+
+// The time limit of a search and a flag which cancels it, polled once per node. Reading the clock
+// is slow compared to a node, so it is only read every few polls, and how many is recalibrated from
+// the node rate measured at each read so the clock is read about every Check_Fraction of the time
+// limit, or right at the deadline if that comes first. Once the time is up or cancel() is called
+// every poll says so, and the search unwinds on its own. A deadline can have a parent, such as that
+// of the main search of a parallel search, whose cancellation also cancels it
+class SparCraft::SearchDeadline
+{
+    enum { Check_Fraction = 100, First_Interval = 16, Max_Interval = 1 << 16 };
+
+    Timer                       _timer;
+    double                      _limitMS;           // 0 means there is no time limit
+    boost::atomic<bool>         _cancelled;
+    const SearchDeadline *      _parent;
+    size_t                      _polls;             // polls since the clock was last read
+    size_t                      _interval;          // polls between reads of the clock
+    double                      _lastReadMS;
+
+    SearchDeadline(const SearchDeadline & rhs);
+    SearchDeadline & operator = (const SearchDeadline & rhs);
+
+public:
+
+    SearchDeadline()
+        : _limitMS      (0)
+        , _cancelled    (false)
+        , _parent       (NULL)
+        , _polls        (0)
+        , _interval     (First_Interval)
+        , _lastReadMS   (0)
+    {
+    }
+
+    // starts the clock of a new search, which also clears a cancellation
+    void start(const double & limitMS, const SearchDeadline * parent = NULL)
+    {
+        _limitMS    = limitMS;
+        _parent     = parent;
+        _polls      = 0;
+        _interval   = First_Interval;
+        _lastReadMS = 0;
+        _cancelled.store(false, boost::memory_order_relaxed);
+        _timer.start();
+    }
+
+    // may be called from any thread
+    void cancel()                                       { _cancelled.store(true, boost::memory_order_relaxed); }
+
+    const bool isCancelled() const
+    {
+        return _cancelled.load(boost::memory_order_relaxed) || (_parent && _parent->isCancelled());
+    }
+
+    // true once the search should stop
+    const bool expired()
+    {
+        if (isCancelled())
+        {
+            return true;
+        }
+
+        if (_limitMS <= 0 || ++_polls < _interval)
+        {
+            return false;
+        }
+
+        const double ms(_timer.getElapsedTimeInMilliSec());
+
+        if (ms >= _limitMS)
+        {
+            cancel();
+            return true;
+        }
+
+        const double msPerPoll(std::max(ms - _lastReadMS, 0.0001) / _polls);
+        const double nextReadMS(std::min(_limitMS / Check_Fraction, _limitMS - ms));
+
+        _interval   = std::max((size_t)1, std::min((size_t)Max_Interval, (size_t)(nextReadMS / msPerPoll)));
+        _polls      = 0;
+        _lastReadMS = ms;
+
+        return false;
+    }
+
+    const double getElapsedTimeInMilliSec()             { return _timer.getElapsedTimeInMilliSec(); }
+};
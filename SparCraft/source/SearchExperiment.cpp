@@ -258,6 +258,31 @@ void SearchExperiment::parseConfigFile(const std::string & filename)
 
             PlayerProperties::Get(playerID).SetResearched(BWAPI::TechTypes::getTechType(techName), true);
         }
+        else if (strcmp(option.c_str(), "Benchmark") == 0)
+        {
+            std::string benchmark;
+            int iterations(0);
+
+            iss >> benchmark;
+            iss >> iterations;
+
+            if (strcmp(benchmark.c_str(), "StateCopy") == 0)
+            {
+                runStateCopyBenchmark(iterations);
+            }
+            else if (strcmp(benchmark.c_str(), "UCT") == 0)
+            {
+                runUCTBenchmark(iterations);
+            }
+            else if (strcmp(benchmark.c_str(), "AlphaBeta") == 0)
+            {
+                runAlphaBetaBenchmark(iterations);
+            }
+            else
+            {
+                System::FatalError("Invalid Benchmark in Configuration File: " + benchmark);
+            }
+        }
         else
         {
             System::FatalError("Invalid Option in Configuration File: " + option);
@@ -265,6 +290,178 @@ void SearchExperiment::parseConfigFile(const std::string & filename)
     }
 }
 
+// Times copy construction and assignment of GameStates with a growing number of units per player.
+// Copies only touch the units in the state, so the time per copy should grow with the unit count
+void SearchExperiment::runStateCopyBenchmark(const int & iterations)
+{
+    const size_t unitCounts[] = { 1, 2, 4, 8, 16, 32, 64, Constants::Max_Units };
+    const size_t numCounts(sizeof(unitCounts) / sizeof(unitCounts[0]));
+
+    std::cout << "\nGameState copy benchmark, " << iterations << " copies per state, sizeof(GameState) = " << sizeof(GameState) << "\n\n";
+    std::cout << "  Units/Player   Construct(ns)   Assign(ns)\n";
+
+    size_t checksum(0);
+
+    for (size_t c(0); c < numCounts; ++c)
+    {
+        GameState state;
+
+        for (size_t u(0); u < unitCounts[c]; ++u)
+        {
+            const Position pos(100 + 32 * (u % 10), 100 + 32 * (u / 10));
+
+            state.addUnit(BWAPI::UnitTypes::Terran_Marine, Players::Player_One, pos);
+            state.addUnit(BWAPI::UnitTypes::Terran_Marine, Players::Player_Two, pos + Position(500, 0));
+        }
+
+        Timer t;
+        t.start();
+
+        for (int i(0); i < iterations; ++i)
+        {
+            GameState copy(state);
+            checksum += copy.numUnits(Players::Player_One);
+        }
+
+        const double constructNS(t.getElapsedTimeInMicroSec() * 1000 / std::max(iterations, 1));
+
+        GameState copy;
+        t.start();
+
+        for (int i(0); i < iterations; ++i)
+        {
+            copy = state;
+            checksum += copy.numUnits(Players::Player_Two);
+        }
+
+        const double assignNS(t.getElapsedTimeInMicroSec() * 1000 / std::max(iterations, 1));
+
+        std::cout << std::setw(14) << unitCounts[c] << std::setw(16) << std::fixed << std::setprecision(1) << constructNS << std::setw(13) << assignNS << "\n";
+    }
+
+    // printed so the copies can't be optimized away
+    std::cout << "\nChecksum " << checksum << "\n\n";
+}
+
+// Times UCT searches of a fixed number of traversals from one state with each parallel method and
+// a growing number of threads. Root parallel threads each search their share of the traversals,
+// tree parallel threads share them, so traversals/sec should grow with the threads for both
+void SearchExperiment::runUCTBenchmark(const int & traversals)
+{
+    const size_t threadCounts[] = { 1, 2, 4, 8, 16 };
+    const size_t numCounts(sizeof(threadCounts) / sizeof(threadCounts[0]));
+    const IDType methods[] = { ParallelMethods::RootParallel, ParallelMethods::TreeParallel };
+
+    GameState state;
+
+    for (size_t u(0); u < 8; ++u)
+    {
+        const Position pos(100 + 32 * (u % 4), 100 + 32 * (u / 4));
+
+        state.addUnit(BWAPI::UnitTypes::Protoss_Dragoon, Players::Player_One, pos);
+        state.addUnit(BWAPI::UnitTypes::Protoss_Dragoon, Players::Player_Two, pos + Position(300, 0));
+    }
+
+    UCTSearchParameters params;
+    params.setMaxTraversals(std::max(traversals, 1));
+    params.addOrderedMoveScript(PlayerModels::NOKDPS);
+    params.addOrderedMoveScript(PlayerModels::KiterDPS);
+
+    std::cout << "\nUCT parallel search benchmark, " << traversals << " traversals per search\n\n";
+    std::cout << "  Method   Threads   Traversals/sec   Speedup\n";
+
+    double serialRate(0);
+
+    for (size_t m(0); m < 2; ++m)
+    {
+        for (size_t c(0); c < numCounts; ++c)
+        {
+            params.setParallelMethod(methods[m]);
+            params.setNumThreads(threadCounts[c]);
+
+            UCTSearch search(params);
+            std::vector<UnitAction> move;
+
+            Timer t;
+            t.start();
+
+            search.doSearch(state, move);
+
+            const double ms(t.getElapsedTimeInMilliSec());
+            const double rate(search.getResults().traversals * 1000.0 / std::max(ms, 0.001));
+
+            if (m == 0 && c == 0)
+            {
+                serialRate = rate;
+            }
+
+            std::cout << std::setw(8) << ParallelMethods::getName(methods[m]) << std::setw(10) << threadCounts[c] 
+                      << std::setw(17) << std::fixed << std::setprecision(0) << rate 
+                      << std::setw(10) << std::setprecision(2) << rate / std::max(serialRate, 0.001) << "\n";
+        }
+    }
+
+    std::cout << "\n";
+}
+
+// Runs a Lazy SMP alpha-beta search with the time limit from every state added so far with a growing
+// number of threads. The helper threads fill the shared transposition table, so with more cores the
+// main thread should finish deeper iterations in the same time
+void SearchExperiment::runAlphaBetaBenchmark(const int & timeLimit)
+{
+    const size_t threadCounts[] = { 1, 2, 4, 8, 16 };
+    const size_t numCounts(sizeof(threadCounts) / sizeof(threadCounts[0]));
+
+    if (states.empty())
+    {
+        System::FatalError("AlphaBeta Benchmark needs the states to be added before it");
+    }
+
+    AlphaBetaSearchParameters params;
+    params.setMaxDepth(50);
+    params.setSearchMethod(SearchMethods::IDAlphaBeta);
+    params.setTimeLimit(std::max(timeLimit, 1));
+    params.addOrderedMoveScript(PlayerModels::NOKDPS);
+    params.addOrderedMoveScript(PlayerModels::KiterDPS);
+
+    std::cout << "\nAlphaBeta Lazy SMP benchmark, " << timeLimit << "ms per search on " << states.size() << " states\n\n";
+    std::cout << "  Threads   Avg Depth   Main Nodes/sec   All Nodes/sec\n";
+
+    for (size_t c(0); c < numCounts; ++c)
+    {
+        params.setNumThreads(threadCounts[c]);
+
+        double depth(0);
+        double mainNodes(0);
+        double allNodes(0);
+        double ms(0);
+
+        for (size_t s(0); s < states.size(); ++s)
+        {
+            // the search holds arrays sized by the unit capacity, too large for the stack
+            boost::shared_ptr<AlphaBetaSearch> search(new AlphaBetaSearch(params));
+            GameState state(states[s]);
+
+            search->doSearch(state);
+
+            const AlphaBetaSearchResults & results(search->getResults());
+
+            // the last iteration was cut off by the time limit
+            depth       += results.maxDepthReached - 1;
+            mainNodes   += (double)results.nodesExpanded;
+            allNodes    += (double)(results.nodesExpanded + results.helperNodesExpanded);
+            ms          += results.timeElapsed;
+        }
+
+        std::cout << std::setw(9) << threadCounts[c] 
+                  << std::setw(12) << std::fixed << std::setprecision(2) << depth / states.size()
+                  << std::setw(17) << std::setprecision(0) << mainNodes * 1000 / std::max(ms, 0.001)
+                  << std::setw(16) << allNodes * 1000 / std::max(ms, 0.001) << "\n";
+    }
+
+    std::cout << "\n";
+}
+
 void SearchExperiment::addState(const std::string & line)
 {
     std::istringstream iss(line);
@@ -470,13 +667,20 @@ void SearchExperiment::addPlayer(const std::string & line)
         size_t timeLimit(0);
         int iterations(1);
         int responses(0);
+        int threads(1);
 
         iss >> timeLimit;
         iss >> enemyPlayerModel;
         iss >> iterations;
         iss >> responses;
 
-        players[playerID].push_back(PlayerPtr(new Player_PortfolioGreedySearch(playerID, PlayerModels::getID(enemyPlayerModel), iterations, responses, timeLimit))); 
+        // optional, more than 1 thread evaluates each improvement step in parallel
+        if (!(iss >> threads))
+        {
+            threads = 1;
+        }
+
+        players[playerID].push_back(PlayerPtr(new Player_PortfolioGreedySearch(playerID, PlayerModels::getID(enemyPlayerModel), iterations, responses, timeLimit, threads))); 
     }
     else if (playerModelID == PlayerModels::AlphaBeta)
     {
@@ -488,6 +692,13 @@ void SearchExperiment::addPlayer(const std::string & line)
         std::string     playoutScript2;
         std::string     playerToMoveMethod;
         std::string     opponentModelScript;
+        int             threads(1);
+        int             transpositionTableMB(Constants::Transposition_Table_MB);
+        std::string     persistentTT;
+        std::string     historyHeuristic;
+        std::string     killerMoves;
+        int             aspirationWindow(0);
+        std::string     principalVariation;
 
         // read in the values
         iss >> timeLimitMS;
@@ -499,6 +710,46 @@ void SearchExperiment::addPlayer(const std::string & line)
         iss >> playerToMoveMethod;
         iss >> opponentModelScript;
 
+        // optional, the threads of a Lazy SMP search
+        if (!(iss >> threads))
+        {
+            threads = 1;
+        }
+
+        // optional, the size of the transposition table in megabytes
+        if (!(iss >> transpositionTableMB))
+        {
+            transpositionTableMB = Constants::Transposition_Table_MB;
+        }
+
+        // optional, whether the table is kept from one search to the next
+        if (!(iss >> persistentTT))
+        {
+            persistentTT = "false";
+        }
+
+        // optional, move ordering by the history heuristic and by killer moves
+        if (!(iss >> historyHeuristic))
+        {
+            historyHeuristic = "false";
+        }
+
+        if (!(iss >> killerMoves))
+        {
+            killerMoves = "false";
+        }
+
+        // optional, the aspiration window around the score of the last iteration and null window searches
+        if (!(iss >> aspirationWindow))
+        {
+            aspirationWindow = 0;
+        }
+
+        if (!(iss >> principalVariation))
+        {
+            principalVariation = "false";
+        }
+
         // convert them to the proper enum types
         int moveOrderingID      = MoveOrderMethod::getID(moveOrdering);
         int evalMethodID        = EvaluationMethods::getID(evalMethod);
@@ -522,6 +773,13 @@ void SearchExperiment::addPlayer(const std::string & line)
         params.setEvalMethod(evalMethodID);
         params.setSimScripts(playoutScriptID1, playoutScriptID2);
         params.setPlayerToMoveMethod(playerToMoveID);
+        params.setNumThreads(std::max(threads, 1));
+        params.setTranspositionTableMB(std::max(transpositionTableMB, 1));
+        params.setPersistentTT(strcmp(persistentTT.c_str(), "true") == 0);
+        params.setHistoryHeuristic(strcmp(historyHeuristic.c_str(), "true") == 0);
+        params.setKillerMoves(strcmp(killerMoves.c_str(), "true") == 0);
+        params.setAspirationWindow(std::max(aspirationWindow, 0));
+        params.setPrincipalVariation(strcmp(principalVariation.c_str(), "true") == 0);
 	
         // add scripts for move ordering
         if (moveOrderingID == MoveOrderMethod::ScriptFirst)
@@ -562,6 +820,12 @@ void SearchExperiment::addPlayer(const std::string & line)
         std::string     playoutScript2;
         std::string     playerToMoveMethod;
         std::string     opponentModelScript;
+        std::string     parallelMethod;
+        int             threads(1);
+        std::string     reuseTree;
+        int             transpositionTableSize(0);
+        double          wideningConstant(0);
+        double          wideningExponent(0.5);
 
         // read in the values
         iss >> timeLimitMS;
@@ -575,6 +839,40 @@ void SearchExperiment::addPlayer(const std::string & line)
         iss >> playerToMoveMethod;
         iss >> opponentModelScript;
 
+        // optional, how the traversals are split over more than 1 thread
+        if (!(iss >> parallelMethod))
+        {
+            parallelMethod = "None";
+        }
+
+        if (!(iss >> threads))
+        {
+            threads = 1;
+        }
+
+        // optional, whether the next search starts from the subtree of its state
+        if (!(iss >> reuseTree))
+        {
+            reuseTree = "false";
+        }
+
+        // optional, entries of the table which shares statistics between transpositions
+        if (!(iss >> transpositionTableSize))
+        {
+            transpositionTableSize = 0;
+        }
+
+        // optional, progressive widening gives a node C * visits^exponent children
+        if (!(iss >> wideningConstant))
+        {
+            wideningConstant = 0;
+        }
+
+        if (!(iss >> wideningExponent))
+        {
+            wideningExponent = 0.5;
+        }
+
         // convert them to the proper enum types
         int moveOrderingID      = MoveOrderMethod::getID(moveOrdering);
         int evalMethodID        = EvaluationMethods::getID(evalMethod);
@@ -582,6 +880,7 @@ void SearchExperiment::addPlayer(const std::string & line)
         int playoutScriptID2    = PlayerModels::getID(playoutScript2);
         int playerToMoveID      = PlayerToMove::getID(playerToMoveMethod);
         int opponentModelID     = PlayerModels::getID(opponentModelScript);
+        int parallelMethodID    = ParallelMethods::getID(parallelMethod);
 
         // construct the parameter object
         UCTSearchParameters params;
@@ -596,6 +895,11 @@ void SearchExperiment::addPlayer(const std::string & line)
         params.setEvalMethod(evalMethodID);
         params.setSimScripts(playoutScriptID1, playoutScriptID2);
         params.setPlayerToMoveMethod(playerToMoveID);
+        params.setParallelMethod(parallelMethodID);
+        params.setNumThreads(threads);
+        params.setReuseTree(strcmp(reuseTree.c_str(), "true") == 0);
+        params.setTranspositionTableSize(transpositionTableSize);
+        params.setWidening(wideningConstant, wideningExponent);
         //params.setGraphVizFilename("__uct.txt");
 
         // add scripts for move ordering
@@ -835,19 +1139,19 @@ void SearchExperiment::runExperiment()
 				// get player one
 				PlayerPtr playerOne(players[0][p1Player]);
 
-				// give it a new transposition table if it's an alpha beta player
+				// give it a new transposition table if it's an alpha beta player which doesn't keep its table
 				Player_AlphaBeta * p1AB = dynamic_cast<Player_AlphaBeta *>(playerOne.get());
-				if (p1AB)
+				if (p1AB && !p1AB->getParams().persistentTT())
 				{
-					p1AB->setTranspositionTable(TTPtr(new TranspositionTable()));
+					p1AB->setTranspositionTable(TTPtr(new TranspositionTable(p1AB->getParams().transpositionTableMB())));
 				}
 
 				// get player two
 				PlayerPtr playerTwo(players[1][p2Player]);
 				Player_AlphaBeta * p2AB = dynamic_cast<Player_AlphaBeta *>(playerTwo.get());
-				if (p2AB)
+				if (p2AB && !p2AB->getParams().persistentTT())
 				{
-					p2AB->setTranspositionTable(TTPtr(new TranspositionTable()));
+					p2AB->setTranspositionTable(TTPtr(new TranspositionTable(p2AB->getParams().transpositionTableMB())));
 				}
 
 				// construct the game
@@ -83,6 +83,9 @@ class SparCraft::SearchExperiment
     std::string currentDateTime();
     void printStateUnits(std::ofstream & results, GameState & state);
     void addGameState(const GameState & state);
+    void runStateCopyBenchmark(const int & iterations);
+    void runUCTBenchmark(const int & traversals);
+    void runAlphaBetaBenchmark(const int & timeLimit);
 
 public:
 
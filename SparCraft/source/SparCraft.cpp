@@ -16,6 +16,9 @@ namespace SparCraft
         // Initialize Weapon and Unit Property Data
         SparCraft::WeaponProperties::Init();
 	    SparCraft::UnitProperties::Init();
+
+        // Initialize Combat Lookup Tables, built from the data above
+        SparCraft::CombatTables::init();
     
         // Initialize EnumData Class Types
         SparCraft::EnumDataInit();
@@ -9,6 +9,7 @@
 #include "GameState.h"
 #include "SearchExperiment.h"
 #include "AnimationFrameData.h"
+#include "CombatTables.h"
 
 #ifdef USING_VISUALIZATION_LIBRARIES
 	#include "Display.h"
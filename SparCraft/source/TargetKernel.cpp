@@ -0,0 +1,185 @@
+#include "TargetKernel.h"
+
+#if !defined(SPARCRAFT_NO_SIMD) && defined(__AVX2__)
+    #define SPARCRAFT_TARGET_AVX2
+    #include <immintrin.h>
+#elif !defined(SPARCRAFT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define SPARCRAFT_TARGET_SSE2
+    #include <emmintrin.h>
+#endif
+
+using namespace SparCraft;
+
+namespace
+{
+    // The flags of a legal target masked with (Alive | Flyer) have to equal one of these two
+    // patterns. A pattern the attacker has no weapon for is set to a value the mask can't produce
+    const unsigned char Target_Flags_Mask   = UnitArrays::Alive | UnitArrays::Flyer;
+    const unsigned char No_Target           = 0xFF;
+
+    const unsigned char groundPattern(const unsigned char & attackerFlags)
+    {
+        return (attackerFlags & UnitArrays::CanAttackGround) ? (unsigned char)UnitArrays::Alive : No_Target;
+    }
+
+    const unsigned char airPattern(const unsigned char & attackerFlags)
+    {
+        return (attackerFlags & UnitArrays::CanAttackAir) ? (unsigned char)(UnitArrays::Alive | UnitArrays::Flyer) : No_Target;
+    }
+
+    // bits of the units in the 16 unit block starting at index which are below numUnits
+    const unsigned int blockMask(const size_t & index, const size_t & numUnits)
+    {
+        return (index + 16 <= numUnits) ? 0xFFFF : ((1u << (numUnits - index)) - 1);
+    }
+}
+
+void TargetKernel::getTargetsScalar(const UnitArrays & arrays, const IDType & targetPlayer, const size_t & numUnits,
+                                    const unsigned char & attackerFlags, const PositionType & x, const PositionType & y,
+                                    const PositionType & rangeSq, UnitMask & targets)
+{
+    const PositionType *    xs(arrays.xRow(targetPlayer));
+    const PositionType *    ys(arrays.yRow(targetPlayer));
+    const unsigned char *   flags(arrays.flagsRow(targetPlayer));
+    const unsigned char     ground(groundPattern(attackerFlags));
+    const unsigned char     air(airPattern(attackerFlags));
+
+    targets.clear();
+
+    for (size_t u(0); u < numUnits; ++u)
+    {
+        const unsigned char f(flags[u] & Target_Flags_Mask);
+        const PositionType  dx(xs[u] - x);
+        const PositionType  dy(ys[u] - y);
+
+        if ((f == ground || f == air) && (dx*dx + dy*dy <= rangeSq))
+        {
+            targets.set(u);
+        }
+    }
+}
+
+#if defined(SPARCRAFT_TARGET_AVX2)
+
+// 8 squared distances per instruction, exact for any int positions
+void TargetKernel::getTargets(const UnitArrays & arrays, const IDType & targetPlayer, const size_t & numUnits,
+                              const unsigned char & attackerFlags, const PositionType & x, const PositionType & y,
+                              const PositionType & rangeSq, UnitMask & targets)
+{
+    const PositionType *    xs(arrays.xRow(targetPlayer));
+    const PositionType *    ys(arrays.yRow(targetPlayer));
+    const unsigned char *   flags(arrays.flagsRow(targetPlayer));
+
+    const __m256i vx(_mm256_set1_epi32(x));
+    const __m256i vy(_mm256_set1_epi32(y));
+    const __m256i vr(_mm256_set1_epi32(rangeSq));
+    const __m128i mask(_mm_set1_epi8((char)Target_Flags_Mask));
+    const __m128i ground(_mm_set1_epi8((char)groundPattern(attackerFlags)));
+    const __m128i air(_mm_set1_epi8((char)airPattern(attackerFlags)));
+
+    targets.clear();
+
+    for (size_t i(0); i < numUnits; i += 16)
+    {
+        const __m128i f(_mm_and_si128(_mm_loadu_si128((const __m128i *)(flags + i)), mask));
+        const unsigned int legal(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(f, ground), _mm_cmpeq_epi8(f, air))) & blockMask(i, numUnits));
+
+        if (!legal)
+        {
+            continue;
+        }
+
+        unsigned int outOfRange(0);
+
+        for (size_t h(0); h < 16; h += 8)
+        {
+            const __m256i dx(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(xs + i + h)), vx));
+            const __m256i dy(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(ys + i + h)), vy));
+            const __m256i d(_mm256_add_epi32(_mm256_mullo_epi32(dx, dx), _mm256_mullo_epi32(dy, dy)));
+
+            outOfRange |= (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(d, vr))) << h;
+        }
+
+        targets.word(i / 32) |= (legal & ~outOfRange) << (i % 32);
+    }
+}
+
+const char * TargetKernel::instructionSet()
+{
+    return "AVX2";
+}
+
+#elif defined(SPARCRAFT_TARGET_SSE2)
+
+// SSE2 has no 32 bit multiply, so the offsets are saturated to 16 bits and dx*dx + dy*dy is
+// done with one multiply-add. This is exact for offsets up to 32767 pixels, anything further
+// away saturates to a distance far beyond any weapon range
+void TargetKernel::getTargets(const UnitArrays & arrays, const IDType & targetPlayer, const size_t & numUnits,
+                              const unsigned char & attackerFlags, const PositionType & x, const PositionType & y,
+                              const PositionType & rangeSq, UnitMask & targets)
+{
+    const PositionType *    xs(arrays.xRow(targetPlayer));
+    const PositionType *    ys(arrays.yRow(targetPlayer));
+    const unsigned char *   flags(arrays.flagsRow(targetPlayer));
+
+    const __m128i vx(_mm_set1_epi32(x));
+    const __m128i vy(_mm_set1_epi32(y));
+    const __m128i vr(_mm_set1_epi32(rangeSq));
+    const __m128i mask(_mm_set1_epi8((char)Target_Flags_Mask));
+    const __m128i ground(_mm_set1_epi8((char)groundPattern(attackerFlags)));
+    const __m128i air(_mm_set1_epi8((char)airPattern(attackerFlags)));
+
+    targets.clear();
+
+    for (size_t i(0); i < numUnits; i += 16)
+    {
+        const __m128i f(_mm_and_si128(_mm_loadu_si128((const __m128i *)(flags + i)), mask));
+        const unsigned int legal(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(f, ground), _mm_cmpeq_epi8(f, air))) & blockMask(i, numUnits));
+
+        if (!legal)
+        {
+            continue;
+        }
+
+        __m128i outOfRange[2];
+
+        for (size_t h(0); h < 2; ++h)
+        {
+            const PositionType * bx(xs + i + 8*h);
+            const PositionType * by(ys + i + 8*h);
+
+            const __m128i dx(_mm_packs_epi32(_mm_sub_epi32(_mm_loadu_si128((const __m128i *)bx), vx), _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(bx + 4)), vx)));
+            const __m128i dy(_mm_packs_epi32(_mm_sub_epi32(_mm_loadu_si128((const __m128i *)by), vy), _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(by + 4)), vy)));
+
+            const __m128i lo(_mm_unpacklo_epi16(dx, dy));
+            const __m128i hi(_mm_unpackhi_epi16(dx, dy));
+
+            outOfRange[h] = _mm_packs_epi32(_mm_cmpgt_epi32(_mm_madd_epi16(lo, lo), vr), _mm_cmpgt_epi32(_mm_madd_epi16(hi, hi), vr));
+        }
+
+        const unsigned int far(_mm_movemask_epi8(_mm_packs_epi16(outOfRange[0], outOfRange[1])));
+
+        targets.word(i / 32) |= (legal & ~far) << (i % 32);
+    }
+}
+
+const char * TargetKernel::instructionSet()
+{
+    return "SSE2";
+}
+
+#else
+
+void TargetKernel::getTargets(const UnitArrays & arrays, const IDType & targetPlayer, const size_t & numUnits,
+                              const unsigned char & attackerFlags, const PositionType & x, const PositionType & y,
+                              const PositionType & rangeSq, UnitMask & targets)
+{
+    getTargetsScalar(arrays, targetPlayer, numUnits, attackerFlags, x, y, rangeSq, targets);
+}
+
+const char * TargetKernel::instructionSet()
+{
+    return "scalar";
+}
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Common.h"
+#include "UnitArrays.hpp"
+#include "UnitMask.hpp"
+
+namespace SparCraft
+{
+namespace TargetKernel
+{
+    // Sets the bit of every unit u < numUnits of targetPlayer which an attacker with the given
+    // UnitArrays flags standing at (x, y) can hit right now: the unit is alive, the attacker has a
+    // weapon for its air / ground type and it is within sqrt(rangeSq). Bits of the other units are cleared.
+    // Uses AVX2 or SSE2 when the compiler targets them, define SPARCRAFT_NO_SIMD to force the scalar code
+    void getTargets(const UnitArrays & arrays, const IDType & targetPlayer, const size_t & numUnits,
+                    const unsigned char & attackerFlags, const PositionType & x, const PositionType & y,
+                    const PositionType & rangeSq, UnitMask & targets);
+
+    // the scalar version, used as the fallback and to check the vector versions
+    void getTargetsScalar(const UnitArrays & arrays, const IDType & targetPlayer, const size_t & numUnits,
+                          const unsigned char & attackerFlags, const PositionType & x, const PositionType & y,
+                          const PositionType & rangeSq, UnitMask & targets);
+
+    // name of the instruction set getTargets was compiled for
+    const char * instructionSet();
+}
+}
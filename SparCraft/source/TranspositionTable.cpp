@@ -1,28 +1,101 @@
 #include "TranspositionTable.h"
 
+#include <new>
+
 using namespace SparCraft;
 
+namespace
+{
+	// the fields of the data word of an entry, from the lowest bit
+	enum { Generation_Shift = 0, Depth_Shift = 8, Type_Shift = 14, NumMoves_Shift = 16, Value_Shift = 32 };
+
+	// number of bits needed to hold the values up to N
+	template <size_t N> struct NumBits	{ enum { value = 1 + NumBits<N / 2>::value }; };
+	template <> struct NumBits<0>		{ enum { value = 0 }; };
+
+	// The move word holds the player, the number of units and then an action code for each unit. The
+	// code of an attack or heal is its target, then come the directions of a move and last the reload
+	// or pass, which a unit never has both of. That fits eight units at the default capacity of 100
+	// and six at 256
+	enum {	Player_Shift = 0, Units_Shift = 1, Codes_Shift = 5,
+			Code_Bits = NumBits<Constants::Max_Moves - 1>::value,
+			Max_Move_Units = (64 - Codes_Shift) / Code_Bits };
+
+	const unsigned short getCheck(const HashType & hash2)
+	{
+		return (unsigned short)(hash2 & 0xFFFF);
+	}
+
+	const unsigned long long getActionCode(const UnitAction & action)
+	{
+		if (action.type() == UnitActionTypes::ATTACK || action.type() == UnitActionTypes::HEAL)
+		{
+			return action.index();
+		}
+		else if (action.type() == UnitActionTypes::MOVE)
+		{
+			return Constants::Max_Units + action.index();
+		}
+
+		return Constants::Max_Units + Constants::Num_Directions;
+	}
+
+	const unsigned long long packMove(const IDType & player, const AlphaBetaMove & move)
+	{
+		const std::vector<UnitAction> & moveVec(move.moveVec());
+
+		if (!move.isValid() || moveVec.empty() || (moveVec.size() > (size_t)Max_Move_Units))
+		{
+			return 0;
+		}
+
+		unsigned long long packed(((unsigned long long)(player & 1) << Player_Shift) | ((unsigned long long)moveVec.size() << Units_Shift));
+
+		for (size_t u(0); u < moveVec.size(); ++u)
+		{
+			packed |= getActionCode(moveVec[u]) << (Codes_Shift + u * Code_Bits);
+		}
+
+		return packed;
+	}
+}
+
 TTEntry::TTEntry()
-	: _hash2(0)
+	: _check(0)
 	, _depth(0)
 	, _type(TTEntry::NONE)
+	, _bestMove(0)
+	, _generation(0)
 {
 
 }
 
-TTEntry::TTEntry(const HashType & hash2, const StateEvalScore & score, const size_t & depth, const int & type, 
-				const IDType & firstPlayer, const AlphaBetaMove & bestFirstMove, const AlphaBetaMove & bestSecondMove)
-	: _hash2(hash2)
+TTEntry::TTEntry(const HashType & hash2, const StateEvalScore & score, const size_t & depth, const int & type,
+				const IDType & player, const AlphaBetaMove & bestMove)
+	: _check(::getCheck(hash2))
 	, _score(score)
 	, _depth(depth)
 	, _type(type)
+	, _bestMove(packMove(player, bestMove))
+	, _generation(0)
 {
-	_bestMoves[firstPlayer] = TTBestMove(bestFirstMove, bestSecondMove);
+
+}
+
+TTEntry::TTEntry(const HashType & hash2, const StateEvalScore & score, const size_t & depth, const int & type, const unsigned long long & bestMove, const unsigned char & generation)
+	: _check(::getCheck(hash2))
+	, _score(score)
+	, _depth(depth)
+	, _type(type)
+	, _bestMove(bestMove)
+	, _generation(generation)
+{
+
 }
 
 const bool TTEntry::hashMatches(const HashType & hash2) const
 {
-	return hash2 == _hash2;
+	return ::getCheck(hash2) == _check;
 }
 
 const bool TTEntry::isValid() const
@@ -30,181 +103,218 @@ const bool TTEntry::isValid() const
 	return _type != TTEntry::NONE;
 }
 
-const HashType & TTEntry::getHash()								const { return _hash2; }
+const unsigned short & TTEntry::getCheck()						const { return _check; }
 const StateEvalScore & TTEntry::getScore()						const { return _score; }
 const size_t & TTEntry::getDepth()								const { return _depth; }
 const int & TTEntry::getType()									const { return _type;  }
-const TTBestMove & TTEntry::getBestMove(const IDType & player)	const { return _bestMoves[player];  }
-void TTEntry::setBestMove(const IDType &firstPlayer, const AlphaBetaMove & bestFirstMove, const AlphaBetaMove & bestSecondMove)
-{
-	_bestMoves[firstPlayer] = TTBestMove(bestFirstMove, bestSecondMove);
-}
+const unsigned long long & TTEntry::getPackedMove()				const { return _bestMove; }
+const unsigned char & TTEntry::getGeneration()					const { return _generation; }
 
-TranspositionTable::TranspositionTable () 
-	: TT(Constants::Transposition_Table_Size, TTEntry())
-	, size(Constants::Transposition_Table_Size)
-    , collisions(0)
-    , lookups(0)
-    , found(0)
-    , notFound(0)
-	, saves(0)
-	, minIndex(0)
-	, maxIndex(0)
-	, saveOverwriteSelf(0)
-	, saveOverwriteOther(0)
-	, saveEmpty(0)
-{
-}
-	
-const TTEntry & TranspositionTable::operator [] (const size_t & hash) const
+// each unit's action is the generated one with its code, so a move which isn't legal in the state,
+// or was made by the other player, isn't returned
+const bool TTEntry::getBestMove(const IDType & player, const MoveArray & moves, std::vector<UnitAction> & moveVec) const
 {
-	return TT[getIndex(hash)];
-}
+	const size_t numUnits((size_t)((_bestMove >> Units_Shift) & 0xF));
 
-const TTEntry & TranspositionTable::get(const size_t & hash) const
-{
-	return TT[getIndex(hash)];
-}
-        
-const size_t TranspositionTable::getSaveIndex(const size_t & index, const HashType & hash2, const size_t & depth) const
-{
-	size_t worstDepth(1000);
-	size_t worstDepthIndex(index);
+	if ((numUnits == 0) || (numUnits != moves.numUnits()) || (((_bestMove >> Player_Shift) & 1) != (player & 1)))
+	{
+		return false;
+	}
+
+	moveVec.clear();
 
-	// scan ahead to find the best spot to store this entryw
-	for (size_t i(index); (i<(index+Constants::Transposition_Table_Scan)) && (i <TT.size()); ++i)
+	for (size_t u(0); u < numUnits; ++u)
 	{
-		// if this index holds worse data about the current state, use it to overwrite
-		if (TT[i].getHash() == hash2 && TT[i].getDepth() < depth)
-		{
-			return i;
-		}
-		else if (TT[i].getHash() == hash2 && TT[i].getDepth() > depth)
-		{
-			printf("We shouldn't get here\n");
-		}
-		// otherwise if this entry is empty, use it
-		else if (!TT[i].isValid())
-		{
-			return i;
-		}
-		// otherwise if the hashes don't match, check to see how old the data is
-		else if (TT[i].getHash() != hash2)
+		const unsigned long long code((_bestMove >> (Codes_Shift + u * Code_Bits)) & ((1ULL << Code_Bits) - 1));
+
+		for (size_t m(0); (moveVec.size() == u) && (m < moves.numMoves(u)); ++m)
 		{
-			if (TT[i].getDepth() < worstDepth)
+			if (getActionCode(moves.getMove(u, m)) == code)
 			{
-				worstDepth = TT[i].getDepth();
-				worstDepthIndex = i;
+				moveVec.push_back(moves.getMove(u, m));
 			}
 		}
+
+		if (moveVec.size() == u)
+		{
+			return false;
+		}
 	}
 
-	return worstDepthIndex;
+	return true;
 }
 
-void TranspositionTable::save(	const HashType & hash1, const HashType & hash2, const StateEvalScore & value, const size_t & depth, const int & type,
-			const IDType & firstPlayer, const AlphaBetaMove & bestFirstMove, const AlphaBetaMove & bestSecondMove)
+TranspositionTable::TranspositionTable (const size_t & megabytes)
+	: _memory(NULL)
+	, _buckets(NULL)
+	, _numBuckets(1)
+	, _generation(0)
 {
-	size_t indexToSave = getSaveIndex(getIndex(hash1), hash2, depth);
-	TTEntry existing = TT[indexToSave];
-
-	if (existing.isValid())
+	// the largest power of two number of buckets which fits in the size
+	while (_numBuckets * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024)
 	{
-		if (existing.getHash() == hash2)
-		{
-			saveOverwriteSelf++;
-		}
-		else
-		{
-			saveOverwriteOther++;
-		}
+		_numBuckets *= 2;
 	}
-	else
+
+	// line the buckets up with the pairs of cache lines
+	_memory = new char[_numBuckets * sizeof(Bucket) + Bucket_Bytes];
+	_buckets = (Bucket *)(_memory + (Bucket_Bytes - ((size_t)_memory % Bucket_Bytes)) % Bucket_Bytes);
+
+	for (size_t b(0); b < _numBuckets; ++b)
 	{
-		saveEmpty++;
+		new (&_buckets[b]) Bucket();
 	}
 
-	saves++;
-	
-	TT[indexToSave] = TTEntry(hash2, value, depth, type, firstPlayer, bestFirstMove, bestSecondMove);
+	clear();
 }
 
-TTEntry * TranspositionTable::lookupScan(const HashType & hash1, const HashType & hash2)
+TranspositionTable::~TranspositionTable ()
 {
-	lookups++;
-	size_t index = getIndex(hash1);
+	delete [] _memory;
+}
 
-	// scan to see if this exists anywhere in the next few entries
-	for (size_t i(index); (i<(index+Constants::Transposition_Table_Scan)) && (i <TT.size()); ++i)
-	{
-		TTEntry * entry = lookup(i, hash2);
+void TranspositionTable::newSearch()
+{
+	_generation = (_generation + 1) & 0xF;
+}
 
-		// if it does, return it
-		if (entry)
+void TranspositionTable::clear()
+{
+	for (size_t b(0); b < _numBuckets; ++b)
+	{
+		for (size_t e(0); e < Bucket_Size; ++e)
 		{
-			found++;
-			return entry;
+			_buckets[b].data[e].store(0, boost::memory_order_relaxed);
+			_buckets[b].move[e].store(0, boost::memory_order_relaxed);
+			_buckets[b].key[e].store(0, boost::memory_order_relaxed);
 		}
 	}
+}
+
+// decodes an entry of a bucket, false if it is empty or was torn by two writes
+const bool TranspositionTable::readEntry(const Bucket & bucket, const size_t & e, TTEntry & entry) const
+{
+	const unsigned long long data(bucket.data[e].load(boost::memory_order_relaxed));
+	const unsigned long long move(bucket.move[e].load(boost::memory_order_relaxed));
+	const unsigned long long check(bucket.key[e].load(boost::memory_order_relaxed) ^ data ^ move);
 
-	// otherwise return null
-	notFound++;
-	return NULL;
+	if (check > 0xFFFF)
+	{
+		return false;
+	}
+
+	entry = TTEntry((HashType)check,
+					StateEvalScore((ScoreType)(int)(data >> Value_Shift), (int)((data >> NumMoves_Shift) & 0xFFFF)),
+					(size_t)((data >> Depth_Shift) & Max_Depth),
+					(int)((data >> Type_Shift) & 3),
+					move,
+					(unsigned char)((data >> Generation_Shift) & 0xF));
+
+	return entry.isValid();
 }
 
-// look up a value in the transposition table, return NULL if not found or collision
-TTEntry * TranspositionTable::lookup(const size_t & index, const HashType & hash2)
+const int TranspositionTable::save(const HashType & hash1, const TTEntry & entry)
 {
-	if (index < minIndex) minIndex = index;
-	if (index > maxIndex) maxIndex = index;
-	
-	TTEntry tte = TT[index];
+	Bucket & bucket(getBucket(hash1));
+	size_t replace(0);
+	int replaceWorth(0);
+	int result(Save_Other);
 
-	// if there is a valid entry at that location
-	if (TT[index].isValid())
+	for (size_t e(0); e < Bucket_Size; ++e)
 	{
-		// test for matching secondary hash
-		if (TT[index].hashMatches(hash2))
+		TTEntry existing;
+
+		// an empty or torn entry is as good as it gets, unless the state is further on
+		if (!readEntry(bucket, e, existing))
+		{
+			if (result != Save_Empty)
+			{
+				replace = e;
+				result = Save_Empty;
+			}
+
+			continue;
+		}
+
+		// the entry of the same state is replaced unless it is deeper, which another thread may have saved,
+		// but one of an earlier search would keep this search from saving its own bounds and move
+		if (existing.getCheck() == entry.getCheck())
 		{
-			found++;
-			return &TT[index];
+			if ((existing.getDepth() > entry.getDepth()) && (existing.getGeneration() == _generation))
+			{
+				return Save_Skipped;
+			}
+
+			replace = e;
+			result = Save_Self;
+			break;
 		}
-		// if no match it is a collision
-		else
+
+		// otherwise the shallowest entry, where each search since an entry was saved counts as a few plies
+		const int worth((int)existing.getDepth() - Replace_Age_Weight * ((_generation - existing.getGeneration()) & 0xF));
+		if (result == Save_Other && (e == 0 || worth < replaceWorth))
 		{
-			//collisions++;
-			return NULL;
+			replace = e;
+			replaceWorth = worth;
 		}
 	}
-	else
+
+	const StateEvalScore & score(entry.getScore());
+	const unsigned long long numMoves(std::min(std::max(score.numMoves(), 0), 0xFFFF));
+	const unsigned long long data(	((unsigned long long)(unsigned int)score.val() << Value_Shift)
+								  | (numMoves << NumMoves_Shift)
+								  | ((unsigned long long)(entry.getType() & 3) << Type_Shift)
+								  | ((unsigned long long)std::min(entry.getDepth(), (size_t)Max_Depth) << Depth_Shift)
+								  | ((unsigned long long)_generation << Generation_Shift));
+	const unsigned long long move(entry.getPackedMove());
+
+	bucket.data[replace].store(data, boost::memory_order_relaxed);
+	bucket.move[replace].store(move, boost::memory_order_relaxed);
+	bucket.key[replace].store(entry.getCheck() ^ data ^ move, boost::memory_order_relaxed);
+
+	return result;
+}
+
+const int TranspositionTable::save(	const HashType & hash1, const HashType & hash2, const StateEvalScore & value, const size_t & depth, const int & type,
+			const IDType & player, const AlphaBetaMove & bestMove)
+{
+	return save(hash1, TTEntry(hash2, value, depth, type, player, bestMove));
+}
+
+// look up a state in its bucket, false if it isn't there
+const bool TranspositionTable::lookup(const HashType & hash1, const HashType & hash2, TTEntry & entry) const
+{
+	const Bucket & bucket(getBucket(hash1));
+
+	for (size_t e(0); e < Bucket_Size; ++e)
 	{
-		//notFound++;
-		return NULL;
+		TTEntry tte;
+
+		if (readEntry(bucket, e, tte) && tte.hashMatches(hash2))
+		{
+			entry = tte;
+			return true;
+		}
 	}
+
+	return false;
 }
-	
-const size_t & TranspositionTable::getSize()		const { return size; }
-const size_t & TranspositionTable::numFound()		const { return found; }	
-const size_t & TranspositionTable::numNotFound()	const { return notFound; }
-const size_t & TranspositionTable::numCollisions()	const { return collisions; }
-const size_t & TranspositionTable::numSaves()		const { return saves; }
-const size_t & TranspositionTable::numLookups()		const { return lookups; }
+
+const size_t TranspositionTable::getSize()			const { return _numBuckets * Bucket_Size; }
+const size_t TranspositionTable::getSizeMB()		const { return _numBuckets * sizeof(Bucket) / (1024 * 1024); }
+const unsigned char & TranspositionTable::getGeneration() const { return _generation; }
 
 const size_t TranspositionTable::getUsage() const
 {
 	size_t sum(0);
-	for (size_t i(0); i<TT.size(); ++i)
+	for (size_t b(0); b < _numBuckets; ++b)
 	{
-		if (TT[i].isValid())
+		for (size_t e(0); e < Bucket_Size; ++e)
 		{
-			sum++;
+			TTEntry entry;
+			sum += readEntry(_buckets[b], e, entry) ? 1 : 0;
 		}
 	}
 
 	return sum;
 }
-
-void TranspositionTable::print()
-{
-	std::cout << "TT stats: " << lookups << " lookups, " << found << " found, " << notFound << " not found, " << collisions << " collions. " << minIndex << " min, " << maxIndex << " max.\n";
-}
\ No newline at end of file
@@ -4,44 +4,52 @@
 #include "Common.h"
 #include "GameState.h"
 #include "UnitAction.hpp"
+#include "MoveArray.h"
+
+#include <boost/atomic.hpp>
 
 namespace SparCraft
 {
 
 class TTEntry
-{	
+{
 public:
 
 	enum { NONE, UPPER, LOWER, ACCURATE };
 
 private:
 
-	HashType			_hash2;
+	unsigned short		_check;			// the low 16 bits of the second hash of the state
 	StateEvalScore		_score;
 	size_t				_depth;
-	TTBestMove			_bestMoves[2];
 	int					_type;
+	unsigned long long	_bestMove;		// the player to move and one action code per unit, 0 if there is no move
+	unsigned char		_generation;	// the search of the table which saved the entry
 
 public:
 
 	TTEntry();
-	TTEntry(const HashType & hash2, const StateEvalScore & score, const size_t & depth, const int & type, 
-			const IDType & firstPlayer, const AlphaBetaMove & bestFirstMove, const AlphaBetaMove & bestSecondMove);
+	TTEntry(const HashType & hash2, const StateEvalScore & score, const size_t & depth, const int & type,
+			const IDType & player, const AlphaBetaMove & bestMove);
+	TTEntry(const HashType & hash2, const StateEvalScore & score, const size_t & depth, const int & type, const unsigned long long & bestMove, const unsigned char & generation);
 
 	const bool hashMatches(const HashType & hash2) const;
 
 	const bool isValid() const;
 
-	const HashType & getHash()									const;
+	const unsigned short & getCheck()							const;
 	const StateEvalScore & getScore()							const;
 	const size_t & getDepth()									const;
 	const int & getType()										const;
-	const TTBestMove & getBestMove(const IDType & player)		const;
-	void setBestMove(const IDType &firstPlayer, const AlphaBetaMove & bestFirstMove, const AlphaBetaMove & bestSecondMove);
+	const unsigned long long & getPackedMove()					const;
+	const unsigned char & getGeneration()						const;
+
+	// the best move if it was the player's, looked up in the moves generated for the state
+	const bool getBestMove(const IDType & player, const MoveArray & moves, std::vector<UnitAction> & moveVec) const;
 
 	void print() const
 	{
-		printf ("%d, %d, %d, %d\n", (int) _hash2, (int) _score.val(), (int) _depth, (int) _type);
+		printf ("%d, %d, %d, %d\n", (int) _check, (int) _score.val(), (int) _depth, (int) _type);
 	}
 };
 
@@ -50,84 +58,94 @@ class TTLookupValue
 {
 	bool		_found;		// did we find a value?
 	bool		_cut;		// should we produce a cut?
-	TTEntry *	_entry;		// the entry we found
+	TTEntry 	_entry;		// a copy of the entry we found
 
 public:
 
 	TTLookupValue()
 		: _found(false)
 		, _cut(false)
-		, _entry(NULL)
 	{
 	}
 
-	TTLookupValue(const bool found, const bool cut, TTEntry * entry)
+	TTLookupValue(const bool found, const bool cut, const TTEntry & entry)
 		: _found(found)
 		, _cut(cut)
 		, _entry(entry)
 	{
-		
+
 	}
 
-	const bool found() const	{ return _found; }
-	const bool cut() const		{ return _cut; }
-	TTEntry * entry() const		{ return _entry; }
+	const bool found() const				{ return _found; }
+	const bool cut() const					{ return _cut; }
+	const TTEntry & entry() const			{ return _entry; }
 };
 
-class TranspositionTable 
+// The table is an array of 128 byte buckets, two cache lines which are fetched together, holding
+// Bucket_Size entries of three words. The first hash of a state picks its bucket, so a probe touches
+// one pair of lines, and 16 bits of the second hash tell the entries in it apart. The data word packs
+// the score, the depth and bound and the search which saved the entry, the move word the best move
+// as one action code per unit, and the last word is the check XORed with the other two. All three
+// are read and written atomically and a read recomputes the check from them, so an entry torn by two
+// threads of a parallel search writing it at once doesn't match anything. A move of more units than
+// fit in its word isn't kept. A new entry replaces the one of the same state unless that one is
+// deeper and of this search, then an empty one, and otherwise the one which is worth the least by its
+// depth and how many searches ago it was saved, which lets a table kept between searches forget old
+// states first
+class TranspositionTable
 {
-	//Array<TTEntry, Constants::Transposition_Table_Size>	TT;
-	//TTEntry TT[Constants::Transposition_Table_Size];
-	std::vector<TTEntry> TT;
+public:
 
-	size_t			size;
+	enum { Bucket_Size = 5, Bucket_Bytes = 128, Max_Depth = 63, Replace_Age_Weight = 8 };
 
-	size_t			minIndex,
-					maxIndex;
+	enum { Save_Skipped, Save_Empty, Save_Self, Save_Other };
 
-	const size_t getIndex(const HashType & hash1) const
+private:
+
+	struct Bucket
 	{
-		return hash1 % size; 
+		boost::atomic<unsigned long long>	data[Bucket_Size];
+		boost::atomic<unsigned long long>	move[Bucket_Size];
+		boost::atomic<unsigned long long>	key[Bucket_Size];
+		char								padding[Bucket_Bytes - 3 * Bucket_Size * sizeof(boost::atomic<unsigned long long>)];
+	};
+
+	char *				_memory;		// the allocation the buckets are aligned in
+	Bucket *			_buckets;
+	size_t				_numBuckets;	// a power of two
+	unsigned char		_generation;	// only changed between searches
+
+	TranspositionTable(const TranspositionTable & rhs);
+	TranspositionTable & operator = (const TranspositionTable & rhs);
+
+	Bucket & getBucket(const HashType & hash1) const
+	{
+		return _buckets[hash1 & (_numBuckets - 1)];
 	}
 
+	const bool readEntry(const Bucket & bucket, const size_t & e, TTEntry & entry) const;
+
 public:
 
-	size_t			collisions,
-					lookups, 
-					found, 
-					notFound,
-					saves,
-					saveOverwriteSelf,
-					saveOverwriteOther,
-					saveEmpty;
-
-	TranspositionTable ();
-	
-	const TTEntry & operator [] (const size_t & hash) const;
-
-	const TTEntry & get(const size_t & hash) const;
-        
-	void save(const HashType & hash1, const TTEntry & entry) ;
-
-	void save(	const HashType & hash1, const HashType & hash2, const StateEvalScore & value, const size_t & depth, const int & type,
-				const IDType & firstPlayer, const AlphaBetaMove & bestFirstMove, const AlphaBetaMove & bestSecondMove);
-
-	TTEntry * lookup(const size_t & index, const HashType & hash2);
-	TTEntry * lookupScan(const HashType & hash1, const HashType & hash2);
-	
-	const size_t & getSize()		const;
-	const size_t & numFound()		const;	
-	const size_t & numNotFound()	const;
-	const size_t & numCollisions()	const;
-	const size_t & numSaves()		const;
-	const size_t & numLookups()		const;
-
-	const size_t getUsage() const;
-
-	const size_t getSaveIndex(const size_t & index, const HashType & hash2, const size_t & depth) const;
-
-	void print();
+	TranspositionTable (const size_t & megabytes = Constants::Transposition_Table_MB);
+	~TranspositionTable ();
+
+	// starts a new search, entries saved by the earlier ones are replaced first
+	void newSearch();
+	void clear();
+
+	const int save(const HashType & hash1, const TTEntry & entry);
+
+	const int save(	const HashType & hash1, const HashType & hash2, const StateEvalScore & value, const size_t & depth, const int & type,
+				const IDType & player, const AlphaBetaMove & bestMove);
+
+	const bool lookup(const HashType & hash1, const HashType & hash2, TTEntry & entry) const;
+
+	const size_t getSize()			const;
+	const size_t getSizeMB()		const;
+	const size_t getUsage()			const;
+	const unsigned char & getGeneration() const;
 };
 
 typedef	boost::shared_ptr<TranspositionTable> TTPtr;
-}
\ No newline at end of file
+}
@@ -2,54 +2,267 @@
 
 #include "Common.h"
 #include "UCTNode.h"
+#include "UCTTranspositionTable.hpp"
+
+#include <boost/thread/mutex.hpp>
 
 namespace SparCraft
 {
     class UCTMemoryPool;
 }
 
+// The memory of a UCT tree: an arena of nodes and a packed array of the actions which make up the
+// moves of the nodes, both addressed by 32 bit index. They grow in fixed size blocks which are kept
+// when a new tree is started, so freeing the last tree is O(1) and a search which fits in the blocks
+// of the previous one doesn't allocate at all. Blocks never move once allocated, so the threads of
+// a tree parallel search can read nodes while another thread adds children, only adding takes the lock.
+// The pool also keeps the transposition table of the search so it is only allocated once
 class SparCraft::UCTMemoryPool
-{	
-    std::vector< std::vector<UCTNode> > _pool;
+{
+    template <class T, int BlockBits>
+    class BlockArray
+    {
+    public:
+
+        enum { Block_Size = 1 << BlockBits, Max_Blocks = 4096 };
+
+    private:
+
+        T *             _blocks[Max_Blocks];
+        size_t          _numBlocks;
+        size_t          _size;
+
+        BlockArray(const BlockArray & rhs);
+        BlockArray & operator = (const BlockArray & rhs);
+
+    public:
+
+        BlockArray()
+            : _numBlocks    (0)
+            , _size         (0)
+        {
+            std::fill(_blocks, _blocks + Max_Blocks, (T *)NULL);
+        }
+
+        ~BlockArray()
+        {
+            for (size_t b(0); b < _numBlocks; ++b)
+            {
+                delete [] _blocks[b];
+            }
+        }
+
+        // the index of a run of n elements, a run never crosses the end of a block
+        const unsigned int alloc(const size_t & n)
+        {
+            if (n > Block_Size)
+            {
+                System::FatalError("UCTMemoryPool Error: Run longer than a block");
+            }
+
+            size_t block(_size >> BlockBits);
+
+            if (n > 0 && ((_size + n - 1) >> BlockBits) != block)
+            {
+                _size = ++block << BlockBits;
+            }
 
-    const size_t    _poolSize;
-    const size_t    _maxChildren;
-    
-    size_t    _currentIndex;
+            if (block >= Max_Blocks)
+            {
+                System::FatalError("UCTMemoryPool Error: Out of memory for the tree");
+            }
+
+            while (block >= _numBlocks)
+            {
+                _blocks[_numBlocks++] = new T[Block_Size];
+            }
+
+            const unsigned int index((unsigned int)_size);
+            _size += n;
+
+            return index;
+        }
+
+        T &             operator [] (const unsigned int & index)            { return _blocks[index >> BlockBits][index & (Block_Size - 1)]; }
+        const T &       operator [] (const unsigned int & index)    const   { return _blocks[index >> BlockBits][index & (Block_Size - 1)]; }
+
+        void            clear()                                             { _size = 0; }
+        const size_t    size()                                      const   { return _size; }
+        const size_t    capacity()                                  const   { return _numBlocks * Block_Size; }
+    };
+
+    BlockArray<UCTNode, 12>     _nodes;
+    BlockArray<UnitAction, 14>  _actions;
+    UCTTranspositionTable       _transpositions;
+    boost::mutex                _mutex;
 
 public:
 
-	UCTMemoryPool(const size_t & poolSize, const size_t & maxChildren)
-        : _pool             (poolSize, std::vector<UCTNode>())
-        , _poolSize         (poolSize)
-        , _maxChildren      (maxChildren)
-        , _currentIndex     (0)
+	UCTMemoryPool()
+    {
+    }
+
+    // clears the pool and returns the root of a new tree
+    UCTNode & newTree()
+    {
+        _nodes.clear();
+        _actions.clear();
+
+        const unsigned int root(_nodes.alloc(1));
+        _nodes[root].init(root, UCTNode::No_Node, Players::Player_None, SearchNodeType::RootNode, 0, 0);
+
+        return _nodes[root];
+    }
+
+    // clears the pool and returns the root of a copy of the subtree of a node in another pool,
+    // every copied run of children has room for at least childCapacity children
+    UCTNode & newTree(UCTMemoryPool & from, const UCTNode & node, const size_t & childCapacity)
+    {
+        UCTNode & root(newTree());
+        root.copyStats(node);
+
+        // pairs of a node in the other pool and its copy here
+        std::vector< std::pair<unsigned int, unsigned int> > open(1, std::make_pair(node.index(), root.index()));
+
+        while (!open.empty())
+        {
+            UCTNode & source(from.getNode(open.back().first));
+            UCTNode & copy(getNode(open.back().second));
+            open.pop_back();
+
+            if (!source.hasChildren())
+            {
+                continue;
+            }
+
+            const unsigned int firstChild(_nodes.alloc(std::max(source.numChildren(), childCapacity)));
+
+            for (size_t c(0); c < source.numChildren(); ++c)
+            {
+                UCTNode &           sourceChild(from.getChild(source, c));
+                const UnitAction *  move(from.getMove(sourceChild));
+                const unsigned int  firstAction(_actions.alloc(sourceChild.numActions()));
+
+                for (size_t a(0); a < sourceChild.numActions(); ++a)
+                {
+                    _actions[firstAction + a] = move[a];
+                }
+
+                _nodes[firstChild + c].init(firstChild + c, copy.index(), sourceChild.getPlayer(), sourceChild.getNodeType(), firstAction, sourceChild.numActions());
+                _nodes[firstChild + c].copyStats(sourceChild);
+                open.push_back(std::make_pair(sourceChild.index(), firstChild + (unsigned int)c));
+            }
+
+            copy.setChildren(firstChild, source.numChildren());
+
+            if (source.isWidened())
+            {
+                copy.finishWidening();
+            }
+            else
+            {
+                copy.finishExpansion();
+            }
+        }
+
+        return root;
+    }
+
+    // adds the moves as the children of the node, the move of child c is made of the actions
+    // from the end of the move before it up to moveEnds[c]
+    void addChildren(UCTNode & parent, const IDType & player, const IDType & nodeType, const std::vector<UnitAction> & actions, const std::vector<size_t> & moveEnds)
     {
-        for (size_t s(0); s<poolSize; ++s)
+        boost::mutex::scoped_lock lock(_mutex);
+
+        const unsigned int firstChild(_nodes.alloc(moveEnds.size()));
+        size_t moveBegin(0);
+
+        for (size_t c(0); c < moveEnds.size(); ++c)
         {
-            _pool[s].reserve(maxChildren);
+            const size_t        numActions(moveEnds[c] - moveBegin);
+            const unsigned int  firstAction(_actions.alloc(numActions));
+
+            for (size_t a(0); a < numActions; ++a)
+            {
+                _actions[firstAction + a] = actions[moveBegin + a];
+            }
+
+            _nodes[firstChild + c].init(firstChild + c, parent.index(), player, nodeType, firstAction, numActions);
+            moveBegin = moveEnds[c];
         }
+
+        parent.setChildren(firstChild, moveEnds.size());
     }
 
-    std::vector<UCTNode> * alloc()
+    // reserves a run of nodes for children which are added one at a time with addChild
+    void reserveChildren(UCTNode & parent, const size_t & capacity)
     {
-        std::vector<UCTNode> & ret(_pool[_currentIndex]);
-        if (ret.size() > 0)
+        boost::mutex::scoped_lock lock(_mutex);
+
+        parent.setChildren(_nodes.alloc(capacity), 0);
+    }
+
+    // moves the children of the node to a new run with room for capacity children and leaves the old
+    // one unused, only the grandchildren have to be told where their parent went. Must not be called
+    // while another thread may be in the subtree of the node
+    void moveChildren(UCTNode & parent, const size_t & capacity)
+    {
+        unsigned int firstChild(0);
         {
-            ret.clear();
+            boost::mutex::scoped_lock lock(_mutex);
+            firstChild = _nodes.alloc(capacity);
         }
 
-        _currentIndex = (_currentIndex + 1) % _poolSize;
-        return &ret;
+        for (size_t c(0); c < parent.numChildren(); ++c)
+        {
+            UCTNode & child(_nodes[firstChild + (unsigned int)c]);
+            child.moveFrom(getChild(parent, c), firstChild + (unsigned int)c);
+
+            for (size_t g(0); g < child.numChildren(); ++g)
+            {
+                getChild(child, g).setParent(child.index());
+            }
+        }
+
+        parent.setChildren(firstChild, parent.numChildren());
     }
 
-    void clearPool()
+    // adds a child with the move to the run reserved for the children of the parent, only one
+    // thread may add children to a node at a time
+    void addChild(UCTNode & parent, const IDType & player, const IDType & nodeType, const std::vector<UnitAction> & move)
     {
-        for (size_t i(0); i<_poolSize; ++i)
+        unsigned int firstAction(0);
         {
-            _pool[i].clear();
+            boost::mutex::scoped_lock lock(_mutex);
+            firstAction = _actions.alloc(move.size());
         }
 
-        _currentIndex = 0;
+        for (size_t a(0); a < move.size(); ++a)
+        {
+            _actions[firstAction + a] = move[a];
+        }
+
+        const unsigned int child(parent.firstChild() + (unsigned int)parent.numChildren());
+        _nodes[child].init(child, parent.index(), player, nodeType, firstAction, move.size());
+        parent.addChild();
+    }
+
+    UCTNode &           getRoot()                                               { return _nodes[0]; }
+    UCTTranspositionTable & getTranspositions()                                 { return _transpositions; }
+    UCTNode &           getNode(const unsigned int & index)                     { return _nodes[index]; }
+    UCTNode &           getChild(const UCTNode & node, const size_t & c)        { return _nodes[node.firstChild() + (unsigned int)c]; }
+    UCTNode &           getParent(const UCTNode & node)                         { return _nodes[node.parent()]; }
+
+    // the actions of the node's move, which are contiguous
+    const UnitAction *  getMove(const UCTNode & node)                   const   { return node.numActions() ? &_actions[node.firstAction()] : NULL; }
+
+    void getMove(const UCTNode & node, std::vector<UnitAction> & move) const
+    {
+        const UnitAction * actions(getMove(node));
+        move.assign(actions, actions + node.numActions());
     }
+
+    const size_t        numNodes()                                      const   { return _nodes.size(); }
+    const size_t        numActions()                                    const   { return _actions.size(); }
+    const size_t        bytesAllocated()                                const   { return _nodes.capacity() * sizeof(UCTNode) + _actions.capacity() * sizeof(UnitAction) + _transpositions.size() * sizeof(UCTTranspositionTable::Entry); }
 };
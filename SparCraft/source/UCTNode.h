@@ -3,133 +3,164 @@
 #include "Common.h"
 #include "UnitAction.hpp"
 
+#include <boost/atomic.hpp>
+
 namespace SparCraft
 {
 
-
+// A node of a UCT tree. Nodes live in a UCTMemoryPool and refer to their parent and children by
+// index, the children of a node are a contiguous run of nodes and its move is a run of actions in
+// the pool's action array, so a node holds no memory of its own and is never copied.
+// The visit and win counters are atomic so that the threads of a tree parallel UCTSearch can
+// update a shared tree. Wins are counted in halves so a draw is still an exact integer add.
+// Children are generated by the one thread which gets the expansion lock of the node, the others
+// only look at them once isExpanded() says they are there. With progressive widening children are
+// added to a run reserved for them later on, again by the one thread which gets the lock, and the
+// number of children is published after each new child is complete. A search with only one thread
+// may also move the run of children to a bigger one
 class UCTNode
 {
+    enum { Not_Expanded, Expanding, Expanded, Widening, Widened };
+
     // uct stat counting variables
-    size_t                      _numVisits;         // total visits to this node
-    double                      _numWins;           // wins from this node
-    double                      _uctVal;            // previous computed UCT value
-            
+    boost::atomic<unsigned int>     _numVisits;         // total visits to this node
+    boost::atomic<unsigned int>     _numHalfWins;       // wins from this node, counted in halves
+    float                           _uctVal;            // previous computed UCT value
+    boost::atomic<unsigned int>     _entry;             // the transposition table entry of the node's state
+
+    // tree links, as indices into the pool
+    unsigned int                    _index;             // this node
+    unsigned int                    _parent;
+    unsigned int                    _firstChild;
+    unsigned int                    _firstAction;       // the move that generated this node
+    unsigned short                  _numActions;
+    boost::atomic<unsigned short>   _numChildren;
+
     // game specific variables
-    size_t                      _player;            // the player who made a move to generate this node
-    IDType                      _nodeType;
-    std::vector<UnitAction>     _move;              // the ove that generated this node
+    unsigned char                   _player;            // the player who made a move to generate this node
+    unsigned char                   _nodeType;
+    boost::atomic<unsigned char>    _expansion;         // whether the children have been generated
 
-    // holds children
-    std::vector<UCTNode>        _children;
+    UCTNode(const UCTNode & rhs);
+    UCTNode & operator = (const UCTNode & rhs);
 
-    // nodes for traversing the tree
-    UCTNode *                   _parent;
-    
 public:
 
+    enum { No_Node = 0xFFFFFFFF, Unknown_Entry = 0xFFFFFFFF };
+
     UCTNode ()
         : _numVisits            (0)
-        , _numWins              (0)
+        , _numHalfWins          (0)
         , _uctVal               (0)
+        , _entry                (Unknown_Entry)
+        , _index                (No_Node)
+        , _parent               (No_Node)
+        , _firstChild           (No_Node)
+        , _firstAction          (0)
+        , _numActions           (0)
+        , _numChildren          (0)
         , _player               (Players::Player_None)
         , _nodeType             (SearchNodeType::Default)
-        , _parent               (NULL)
+        , _expansion            (Not_Expanded)
     {
 
     }
 
-    UCTNode (UCTNode * parent, const IDType player, const IDType nodeType, const std::vector<UnitAction> & move, const size_t & maxChildren, std::vector<UCTNode> * fromPool = NULL)
-        : _numVisits            (0)
-        , _numWins              (0)
-        , _uctVal               (0)
-        , _player               (player)
-        , _nodeType             (nodeType)
-        , _move                 (move)
-        , _parent               (parent)
+    // resets a node handed out by the pool
+    void init(const unsigned int & index, const unsigned int & parent, const IDType & player, const IDType & nodeType, const unsigned int & firstAction, const size_t & numActions)
     {
-        _children.reserve(maxChildren);
+        _numVisits.store(0, boost::memory_order_relaxed);
+        _numHalfWins.store(0, boost::memory_order_relaxed);
+        _expansion.store(Not_Expanded, boost::memory_order_relaxed);
+        _entry.store(Unknown_Entry, boost::memory_order_relaxed);
+        _uctVal         = 0;
+        _index          = index;
+        _parent         = parent;
+        _firstChild     = No_Node;
+        _firstAction    = firstAction;
+        _numActions     = (unsigned short)numActions;
+        _numChildren.store(0, boost::memory_order_relaxed);
+        _player         = (unsigned char)player;
+        _nodeType       = (unsigned char)nodeType;
     }
 
-    const size_t    numVisits()                 const           { return _numVisits; }
-    const double    numWins()                   const           { return _numWins; }
-    const size_t    numChildren()               const           { return _children.size(); }
+    const size_t    numVisits()                 const           { return _numVisits.load(boost::memory_order_relaxed); }
+    const double    numWins()                   const           { return 0.5 * _numHalfWins.load(boost::memory_order_relaxed); }
+    const size_t    numHalfWins()               const           { return _numHalfWins.load(boost::memory_order_relaxed); }
+    const size_t    numChildren()               const           { return _numChildren.load(boost::memory_order_acquire); }
     const double    getUCTVal()                 const           { return _uctVal; }
     const bool      hasChildren()               const           { return numChildren() > 0; }
     const size_t    getNodeType()               const           { return _nodeType; }
     const IDType    getPlayer()                 const           { return _player; }
 
-    UCTNode *       getParent()                 const           { return _parent; }
-    UCTNode &       getChild(const size_t & c)                  { return _children[c]; }
+    const unsigned int & index()                const           { return _index; }
+    const unsigned int & parent()               const           { return _parent; }
+    const unsigned int & firstChild()           const           { return _firstChild; }
+    const unsigned int & firstAction()          const           { return _firstAction; }
+    const size_t    numActions()                const           { return _numActions; }
 
-    void            setUCTVal(double val)                       { _uctVal = val; }
-    void            incVisits()                                 { _numVisits++; }
-    void            addWins(double val)                         { _numWins += val; }
+    // the entry is only looked up once the node is visited, so it is Unknown_Entry until then
+    const unsigned int entry()                  const           { return _entry.load(boost::memory_order_relaxed); }
+    void            setEntry(const unsigned int & entry)        { _entry.store(entry, boost::memory_order_relaxed); }
 
-    std::vector<UCTNode> & getChildren()                        { return _children; }
+    void            setUCTVal(double val)                       { _uctVal = (float)val; }
+    void            incVisits()                                 { _numVisits.fetch_add(1, boost::memory_order_relaxed); }
+    void            addWins(double val)                         { _numHalfWins.fetch_add((unsigned int)(val * 2), boost::memory_order_relaxed); }
+    void            addVisits(const size_t & visits)            { _numVisits.fetch_add((unsigned int)visits, boost::memory_order_relaxed); }
+    void            addHalfWins(const size_t & halfWins)        { _numHalfWins.fetch_add((unsigned int)halfWins, boost::memory_order_relaxed); }
+    void            removeHalfWins(const size_t & halfWins)     { _numHalfWins.fetch_sub((unsigned int)halfWins, boost::memory_order_relaxed); }
 
-    const std::vector<UnitAction> & getMove() const
-    {
-        return _move;
-    }
+    // counts a visit and returns the number of visits before it
+    const size_t    addVisit()                                  { return _numVisits.fetch_add(1, boost::memory_order_relaxed); }
 
-    void setMove(const std::vector<UnitAction> & move)
+    // the statistics of the same node in another tree
+    void copyStats(const UCTNode & rhs)
     {
-        _move = move;
+        _numVisits.store(rhs._numVisits.load(boost::memory_order_relaxed), boost::memory_order_relaxed);
+        _numHalfWins.store(rhs._numHalfWins.load(boost::memory_order_relaxed), boost::memory_order_relaxed);
+        _uctVal = rhs._uctVal;
     }
 
-    void addChild(UCTNode * parent, const IDType player, const IDType nodeType, const std::vector<UnitAction> & move, const size_t & maxChildren, std::vector<UCTNode> * fromPool = NULL)
+    void setChildren(const unsigned int & firstChild, const size_t & numChildren)
     {
-        _children.push_back(UCTNode(parent, player, nodeType, move, maxChildren));
+        _firstChild     = firstChild;
+        _numChildren.store((unsigned short)numChildren, boost::memory_order_release);
     }
 
-    UCTNode & mostVisitedChild() 
-    {
-        UCTNode * mostVisitedChild = NULL;
-        size_t mostVisits = 0;
+    void setParent(const unsigned int & parent)                 { _parent = parent; }
 
-       for (size_t c(0); c < numChildren(); ++c)
-       {
-           UCTNode & child = getChild(c);
+    // takes over everything of a node which is moved to this index of the pool
+    void moveFrom(const UCTNode & rhs, const unsigned int & index)
+    {
+        init(index, rhs._parent, rhs._player, rhs._nodeType, rhs._firstAction, rhs._numActions);
+        copyStats(rhs);
+        setEntry(rhs.entry());
+        setChildren(rhs._firstChild, rhs.numChildren());
+        _expansion.store(rhs._expansion.load(boost::memory_order_relaxed), boost::memory_order_relaxed);
+    }
 
-           if (!mostVisitedChild || (child.numVisits() > mostVisits))
-           {
-               mostVisitedChild = &child;
-               mostVisits = child.numVisits();
-           }
-       }
+    // publishes a child which was added after the last one
+    void addChild()                                             { _numChildren.fetch_add(1, boost::memory_order_release); }
 
-       return *mostVisitedChild;
+    // true for the one thread which gets to generate the children of this node
+    const bool      tryLockExpansion()
+    {
+        unsigned char expected(Not_Expanded);
+        return _expansion.compare_exchange_strong(expected, (unsigned char)Expanding, boost::memory_order_acquire);
     }
 
-    UCTNode & bestUCTValueChild(const bool maxPlayer, const UCTSearchParameters & params) 
+    void            finishExpansion()                           { _expansion.store(Expanded, boost::memory_order_release); }
+    const bool      isExpanded()                const           { return _expansion.load(boost::memory_order_acquire) >= Expanded; }
+
+    // true for the one thread which gets to add more children to an expanded node
+    const bool      tryLockWidening()
     {
-        UCTNode * bestChild = NULL;
-        double bestVal = maxPlayer ? std::numeric_limits<double>::min() : std::numeric_limits<double>::max();
-
-        for (size_t c(0); c < numChildren(); ++c)
-        {
-            UCTNode & child = getChild(c);
-       
-            double winRate      = (double)child.numWins() / (double)child.numVisits();
-            double uctVal       = params.cValue() * sqrt( log( (double)numVisits() ) / ( child.numVisits() ) );
-			double currentVal   = maxPlayer ? (winRate + uctVal) : (winRate - uctVal);
-
-            if (maxPlayer)
-            {
-                if (currentVal > bestVal)
-                {
-                    bestVal             = currentVal;
-			        bestChild           = &child;
-                }
-            }
-            else if (currentVal < bestVal)
-            {
-                bestVal             = currentVal;
-		        bestChild           = &child;
-            }
-        }
-
-        return *bestChild;
+        unsigned char expected(Expanded);
+        return _expansion.compare_exchange_strong(expected, (unsigned char)Widening, boost::memory_order_acquire);
     }
+
+    // the node has all the children it will ever get
+    void            finishWidening()                            { _expansion.store(Widened, boost::memory_order_release); }
+    const bool      isWidened()                 const           { return _expansion.load(boost::memory_order_acquire) == Widened; }
 };
-}
\ No newline at end of file
+}
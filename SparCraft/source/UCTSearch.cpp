@@ -1,10 +1,21 @@
 #include "UCTSearch.h"
 
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
 using namespace SparCraft;
 
 UCTSearch::UCTSearch(const UCTSearchParameters & params) 
 	: _params(params)
+    , _searchRoot(NULL)
     , _memoryPool(NULL)
+    , _previousPool(NULL)
+    , _previousState(NULL)
+    , _transpositions(NULL)
+    , _shared(false)
+    , _random(NULL)
+    , _traversalCounter(NULL)
 {
     for (size_t p(0); p<Constants::Num_Players; ++p)
     {
@@ -27,22 +38,275 @@ void UCTSearch::setMemoryPool(UCTMemoryPool * pool)
     _memoryPool = pool;
 }
 
+void UCTSearch::setRandomSeed(const unsigned int & seed)
+{
+    _gen.seed(seed);
+    _random = &_gen;
+}
+
+void UCTSearch::setPreviousTree(UCTMemoryPool * pool, const GameState & state)
+{
+    _previousPool = pool;
+    _previousState = &state;
+}
+
+// Looks for the state we search from in the tree of the previous search. If a node has the same
+// state hash and its children are moves of the player our root would choose for, a copy of its
+// subtree with all its statistics becomes our tree. Returns NULL if there is no such node
+UCTNode * UCTSearch::retainTree(const GameState & initialState)
+{
+    // the root's children are generated after it calls finishedMoving, so are those of every other node
+    GameState target(initialState);
+    target.finishedMoving();
+
+    GameState   state(*_previousState);
+    UCTNode *   found(NULL);
+
+    findState(_previousPool->getRoot(), state, target, target.calculateHash(0), found);
+
+    if (!found)
+    {
+        return NULL;
+    }
+
+    const IDType whoCanMove(target.whoCanMove());
+    const IDType playerToMove((whoCanMove == Players::Player_Both) ? _params.maxPlayer() : whoCanMove);
+
+    if (found->hasChildren() && (_previousPool->getChild(*found, 0).getPlayer() != playerToMove))
+    {
+        return NULL;
+    }
+
+    // with progressive widening the copied nodes need room to get more children
+    UCTNode & root(_memoryPool->newTree(*_previousPool, *found, (_params.wideningConstant() > 0) ? _params.maxChildren() : 0));
+    _results.retainedVisits = (int)root.numVisits();
+
+    if (_transpositions)
+    {
+        GameState rootState(initialState);
+        addTranspositions(root, rootState);
+    }
+
+    return &root;
+}
+
+// searches the visited part of the subtree of a node, state is the state before the node's moves
+void UCTSearch::findState(UCTNode & node, GameState & state, const GameState & target, const HashType & targetHash, UCTNode * & found)
+{
+    updateState(*_previousPool, node, state, false);
+
+    // time never goes back, so nothing below a later state can be ours
+    if (state.getTime() > target.getTime())
+    {
+        return;
+    }
+
+    // the moves of a first sim node are only made with the second player's
+    if (node.getNodeType() != SearchNodeType::FirstSimNode && state.getTime() == target.getTime() && state.calculateHash(0) == targetHash)
+    {
+        found = &node;
+        return;
+    }
+
+    for (size_t c(0); !found && c < node.numChildren(); ++c)
+    {
+        UCTNode & child(_previousPool->getChild(node, c));
+
+        if (child.numVisits() > 0)
+        {
+            GameState childState(state);
+            findState(child, childState, target, targetHash, found);
+        }
+    }
+}
+
+// Looks up the node's state in the transposition table the first time the node is visited. The key
+// is the state after the node's moves and the player who made them, since that player decides who
+// goes first at the next simultaneous move. The moves of a first sim node are only made together
+// with the second player's, so it is keyed by the state before them and the hash of its move
+void UCTSearch::findTransposition(UCTNode & node, const GameState & state)
+{
+    if (node.entry() != UCTNode::Unknown_Entry)
+    {
+        return;
+    }
+
+    const bool  firstSim(node.getNodeType() == SearchNodeType::FirstSimNode);
+    HashType    hash[2];
+
+    for (size_t h(0); h < 2; ++h)
+    {
+        hash[h] = Hash::jenkinsHashCombine(state.calculateHash(h), (int)(firstSim ? 256 : 0) + node.getPlayer());
+
+        if (firstSim)
+        {
+            hash[h] ^= getMoveHash(node, h);
+        }
+    }
+
+    bool found(false);
+    node.setEntry(_transpositions->find(hash[0], hash[1], found));
+
+    if (found)
+    {
+        _results.transpositions++;
+    }
+}
+
+// hash of the actions of the node's move, which doesn't depend on the order they are in
+const HashType UCTSearch::getMoveHash(const UCTNode & node, const size_t & hashNum) const
+{
+    const UnitAction *  move(_memoryPool->getMove(node));
+    HashType            hash(0);
+
+    for (size_t a(0); a < node.numActions(); ++a)
+    {
+        hash ^= Hash::jenkinsHashCombine(Hash::values[hashNum].getUnitIDHash(move[a].player(), move[a].unit()), (move[a].type() << 8) | move[a].index());
+    }
+
+    return hash;
+}
+
+// adds the statistics of the visited nodes of a retained tree to the transposition table,
+// state is the state before the node's moves
+void UCTSearch::addTranspositions(UCTNode & node, GameState & state)
+{
+    updateState(node, state, false);
+
+    UCTTranspositionTable::Entry * entry(getTransposition(node));
+
+    if (entry)
+    {
+        entry->addVisits(node.numVisits());
+        entry->addHalfWins(node.numHalfWins());
+    }
+
+    for (size_t c(0); c < node.numChildren(); ++c)
+    {
+        UCTNode & child(_memoryPool->getChild(node, c));
+
+        if (child.numVisits() > 0)
+        {
+            GameState childState(state);
+            addTranspositions(child, childState);
+        }
+    }
+}
+
+// The visits and wins UCT uses for a node. With a transposition table they are those of its state
+// over every path to it, which also merges children that were generated with the same move twice,
+// so the root's move has to be picked by them as well or such a move would have its visits split
+void UCTSearch::getStats(const UCTNode & node, double & visits, double & wins)
+{
+    const UCTTranspositionTable::Entry * entry(getTransposition(node));
+
+    if (entry && entry->numVisits() > 0)
+    {
+        visits  = (double)entry->numVisits();
+        wins    = entry->numWins();
+    }
+    else
+    {
+        visits  = (double)node.numVisits();
+        wins    = node.numWins();
+    }
+}
+
+// the transposition table entry of the node's state, NULL if it has none
+UCTTranspositionTable::Entry * UCTSearch::getTransposition(const UCTNode & node)
+{
+    const unsigned int entry(node.entry());
+
+    if (!_transpositions || entry == UCTNode::Unknown_Entry || entry == UCTTranspositionTable::No_Entry)
+    {
+        return NULL;
+    }
+
+    return &_transpositions->getEntry(entry);
+}
+
 void UCTSearch::doSearch(GameState & initialState, std::vector<UnitAction> & move)
 {
     Timer t;
     t.start();
 
-    _rootNode = UCTNode(NULL, Players::Player_None, SearchNodeType::RootNode, _actionVec, _params.maxChildren(), _memoryPool ? _memoryPool->alloc() : NULL);
+    if (!_memoryPool)
+    {
+        _ownPool = boost::shared_ptr<UCTMemoryPool>(new UCTMemoryPool());
+        _memoryPool = _ownPool.get();
+    }
+
+    // the tree of a root parallel search only holds the merged root children, so it isn't reused
+    const bool rootParallel(_params.numThreads() > 1 && _params.parallelMethod() == ParallelMethods::RootParallel);
+
+    // the threads of a root parallel search each have a table of their own
+    if (_params.transpositionTableSize() > 0 && !rootParallel)
+    {
+        _transpositions = &_memoryPool->getTranspositions();
+        _transpositions->resize(_params.transpositionTableSize());
+    }
+
+    _searchRoot = (_params.reuseTree() && _previousPool && !rootParallel) ? retainTree(initialState) : NULL;
 
+    if (!_searchRoot)
+    {
+        _searchRoot = &_memoryPool->newTree();
+    }
+
+    if (rootParallel)
+    {
+        doRootParallelSearch(initialState, t);
+    }
+    else if (_params.numThreads() > 1 && _params.parallelMethod() == ParallelMethods::TreeParallel)
+    {
+        doTreeParallelSearch(initialState, t);
+    }
+    else
+    {
+        doTraversals(initialState, t);
+    }
+
+    // choose the move to return, a root which was never expanded because there were too few
+    // traversals has no children to choose from, so it gets the move of a script
+    if (_searchRoot->numChildren() == 0)
+    {
+        MoveArray moves;
+        const IDType playerToMove(getPlayerToMove(*_searchRoot, initialState));
+        initialState.generateMoves(moves, playerToMove);
+        Player_NOKDPS(playerToMove).getMoves(initialState, moves, move);
+    }
+    else if (_params.rootMoveSelectionMethod() == UCTMoveSelect::HighestValue)
+    {
+        _memoryPool->getMove(bestUCTValueChild(*_searchRoot, true), move);
+    }
+    else if (_params.rootMoveSelectionMethod() == UCTMoveSelect::MostVisited)
+    {
+        _memoryPool->getMove(mostVisitedChild(*_searchRoot), move);
+    }
+
+    if (_params.graphVizFilename().length() > 0)
+    {
+        //printSubTree(*_searchRoot, initialState, _params.graphVizFilename());
+        //system("\"C:\\Program Files (x86)\\Graphviz2.30\\bin\\dot.exe\" < __uct.txt -Tpng > uct.png");
+    }
+
+    double ms = t.getElapsedTimeInMilliSec();
+    _results.timeElapsed = ms;
+    //printf("Search took %lf ms\n", ms);
+    //printf("Hello\n");
+}
+
+void UCTSearch::doTraversals(GameState & initialState, Timer & timer)
+{
     // do the required number of traversals
     for (size_t traversals(0); traversals < _params.maxTraversals(); ++traversals)
     {
         GameState state(initialState);
-        traverse(_rootNode, state);
+        traverse(*_searchRoot, state);
 
         if (traversals && (traversals % 5 == 0))
         {
-            if (_params.timeLimit() && (t.getElapsedTimeInMilliSec() >= _params.timeLimit()))
+            if (_params.timeLimit() && (timer.getElapsedTimeInMilliSec() >= _params.timeLimit()))
             {
                 break;
             }
@@ -50,30 +314,185 @@ void UCTSearch::doSearch(GameState & initialState, std::vector<UnitAction> & mov
 
         _results.traversals++;
 
-        //printSubTree(_rootNode, initialState, "__uct.txt");
+        //printSubTree(*_searchRoot, initialState, "__uct.txt");
         //system("\"C:\\Program Files (x86)\\Graphviz2.30\\bin\\dot.exe\" < __uct.txt -Tpng > uct.png");
     }
+}
+
+// Root parallelization: every thread searches a tree of its own from the root with its own random
+// generator and a share of the traversals. The visits and wins of the root children are then summed
+// up by move, and the move is picked from the merged root as if it came from one tree. The threads
+// only traverse, since no move of their own trees is used
+void UCTSearch::doRootParallelSearch(GameState & initialState, Timer & timer)
+{
+    const size_t numThreads(_params.numThreads());
 
-    // choose the move to return
-    if (_params.rootMoveSelectionMethod() == UCTMoveSelect::HighestValue)
+    UCTSearchParameters params(_params);
+    params.setParallelMethod(ParallelMethods::None);
+    params.setNumThreads(1);
+
+    std::vector< boost::shared_ptr<UCTSearch> > searches;
+    boost::thread_group                         threads;
+
+    for (size_t t(0); t < numThreads; ++t)
     {
-        move = _rootNode.bestUCTValueChild(true, _params).getMove();
+        params.setMaxTraversals(_params.maxTraversals() / numThreads + ((t < _params.maxTraversals() % numThreads) ? 1 : 0));
+
+        boost::shared_ptr<UCTSearch> search(new UCTSearch(params));
+        search->_ownPool = boost::shared_ptr<UCTMemoryPool>(new UCTMemoryPool());
+        search->_memoryPool = search->_ownPool.get();
+        search->_searchRoot = &search->_memoryPool->newTree();
+        search->setRandomSeed(rand());
+
+        // the threads of a root parallel search each have a table of their own
+        if (params.transpositionTableSize() > 0)
+        {
+            search->_transpositions = &search->_memoryPool->getTranspositions();
+            search->_transpositions->resize(params.transpositionTableSize());
+        }
+
+        searches.push_back(search);
     }
-    else if (_params.rootMoveSelectionMethod() == UCTMoveSelect::MostVisited)
+
+    // each thread gets a copy of the timer of its own
+    for (size_t t(0); t < numThreads; ++t)
     {
-        move = _rootNode.mostVisitedChild().getMove();
+        threads.create_thread(boost::bind(&UCTSearch::doTraversals, searches[t].get(), boost::ref(initialState), timer));
     }
 
-    if (_params.graphVizFilename().length() > 0)
+    threads.join_all();
+
+    mergeRootChildren(searches);
+
+    for (size_t t(0); t < numThreads; ++t)
     {
-        //printSubTree(_rootNode, initialState, _params.graphVizFilename());
-        //system("\"C:\\Program Files (x86)\\Graphviz2.30\\bin\\dot.exe\" < __uct.txt -Tpng > uct.png");
+        addResults(searches[t]->getResults());
     }
+}
 
-    double ms = t.getElapsedTimeInMilliSec();
-    _results.timeElapsed = ms;
-    //printf("Search took %lf ms\n", ms);
-    //printf("Hello\n");
+// Makes the root children of the searches the children of our root, adding up the visits and wins
+// of the children which have the same move in more than one tree
+void UCTSearch::mergeRootChildren(std::vector< boost::shared_ptr<UCTSearch> > & searches)
+{
+    std::vector<size_t> visits;
+    std::vector<size_t> halfWins;
+    IDType              player(Players::Player_None);
+    IDType              nodeType(SearchNodeType::Default);
+
+    _childActions.clear();
+    _childMoveEnds.clear();
+
+    for (size_t t(0); t < searches.size(); ++t)
+    {
+        UCTMemoryPool & pool(*searches[t]->_memoryPool);
+        UCTNode &       root(*searches[t]->_searchRoot);
+
+        _searchRoot->addVisits(root.numVisits());
+        _searchRoot->addHalfWins(root.numHalfWins());
+
+        for (size_t c(0); c < root.numChildren(); ++c)
+        {
+            UCTNode &           child(pool.getChild(root, c));
+            const UnitAction *  move(pool.getMove(child));
+
+            player = child.getPlayer();
+            nodeType = child.getNodeType();
+
+            size_t match(0);
+            size_t moveBegin(0);
+            for (; match < _childMoveEnds.size(); moveBegin = _childMoveEnds[match++])
+            {
+                if ((_childMoveEnds[match] - moveBegin == child.numActions()) && std::equal(move, move + child.numActions(), _childActions.begin() + moveBegin))
+                {
+                    break;
+                }
+            }
+
+            if (match == _childMoveEnds.size())
+            {
+                _childActions.insert(_childActions.end(), move, move + child.numActions());
+                _childMoveEnds.push_back(_childActions.size());
+                visits.push_back(0);
+                halfWins.push_back(0);
+            }
+
+            visits[match] += child.numVisits();
+            halfWins[match] += child.numHalfWins();
+        }
+    }
+
+    // none of the trees got past its root
+    if (_childMoveEnds.empty())
+    {
+        return;
+    }
+
+    _memoryPool->addChildren(*_searchRoot, player, nodeType, _childActions, _childMoveEnds);
+
+    for (size_t c(0); c < _searchRoot->numChildren(); ++c)
+    {
+        _memoryPool->getChild(*_searchRoot, c).addVisits(visits[c]);
+        _memoryPool->getChild(*_searchRoot, c).addHalfWins(halfWins[c]);
+    }
+}
+
+// Tree parallelization: the threads all traverse the tree of this search, each one through a
+// UCTSearch of its own which holds its move generation buffers, scripts and random generator
+void UCTSearch::doTreeParallelSearch(GameState & initialState, Timer & timer)
+{
+    boost::atomic<size_t>                       traversalCounter(0);
+    std::vector< boost::shared_ptr<UCTSearch> > searches;
+    boost::thread_group                         threads;
+
+    for (size_t t(0); t < _params.numThreads(); ++t)
+    {
+        searches.push_back(boost::shared_ptr<UCTSearch>(new UCTSearch(_params)));
+        searches[t]->_searchRoot = _searchRoot;
+        searches[t]->_memoryPool = _memoryPool;
+        searches[t]->_transpositions = _transpositions;
+        searches[t]->_shared = true;
+        searches[t]->_traversalCounter = &traversalCounter;
+        searches[t]->setRandomSeed(rand());
+    }
+
+    for (size_t t(0); t < _params.numThreads(); ++t)
+    {
+        threads.create_thread(boost::bind(&UCTSearch::doSharedTraversals, searches[t].get(), boost::ref(initialState), timer));
+    }
+
+    threads.join_all();
+
+    for (size_t t(0); t < _params.numThreads(); ++t)
+    {
+        addResults(searches[t]->getResults());
+    }
+}
+
+// the loop of one tree parallel thread, the threads together make at most maxTraversals traversals
+void UCTSearch::doSharedTraversals(GameState & initialState, Timer timer)
+{
+    while (_traversalCounter->fetch_add(1, boost::memory_order_relaxed) < _params.maxTraversals())
+    {
+        GameState state(initialState);
+        traverseShared(*_searchRoot, state);
+
+        _results.traversals++;
+
+        if ((_results.traversals % 5 == 0) && _params.timeLimit() && (timer.getElapsedTimeInMilliSec() >= _params.timeLimit()))
+        {
+            break;
+        }
+    }
+}
+
+void UCTSearch::addResults(const UCTSearchResults & results)
+{
+    _results.traversals     += results.traversals;
+    _results.traverseCalls  += results.traverseCalls;
+    _results.nodesVisited   += results.nodesVisited;
+    _results.totalVisits    += results.totalVisits;
+    _results.nodesCreated   += results.nodesCreated;
+    _results.transpositions += results.transpositions;
 }
 
 const bool UCTSearch::searchTimeOut()
@@ -222,7 +641,7 @@ const IDType UCTSearch::getPlayerToMove(UCTNode & node, const GameState & state)
 		    }
 		    else if (policy == SparCraft::PlayerToMove::Random)
 		    {
-			    return rand() % 2;
+			    return _random ? boost::random::uniform_int_distribution<>(0, 1)(*_random) : rand() % 2;
 		    }
 
             // we should never get to this state
@@ -239,24 +658,36 @@ const IDType UCTSearch::getPlayerToMove(UCTNode & node, const GameState & state)
 UCTNode & UCTSearch::UCTNodeSelect(UCTNode & parent)
 {
     UCTNode *   bestNode    = NULL;
-    bool        maxPlayer   = isRoot(parent) || (parent.getChild(0).getPlayer() == _params.maxPlayer());
+    bool        maxPlayer   = isRoot(parent) || (_memoryPool->getChild(parent, 0).getPlayer() == _params.maxPlayer());
     double      bestVal     = maxPlayer ? std::numeric_limits<double>::min() : std::numeric_limits<double>::max();
+    double      parentVisits(0);
+    double      visits(0);
+    double      wins(0);
+
+    // with transpositions these are the visits of the parent's state over every path to it
+    getStats(parent, parentVisits, wins);
          
     // loop through each child to find the best node
     for (size_t c(0); c < parent.numChildren(); ++c)
     {
-        UCTNode & child = parent.getChild(c);
+        UCTNode & child = _memoryPool->getChild(parent, c);
 
 		double currentVal(0);
 	
         // if we have visited this node already, get its UCT value
 		if (child.numVisits() > 0)
 		{
-			double winRate    = (double)child.numWins() / (double)child.numVisits();
-            double uctVal     = _params.cValue() * sqrt( log( (double)parent.numVisits() ) / ( child.numVisits() ) );
+            getStats(child, visits, wins);
+
+			double winRate    = wins / visits;
+            double uctVal     = _params.cValue() * sqrt( log( parentVisits ) / visits );
 			currentVal        = maxPlayer ? (winRate + uctVal) : (winRate - uctVal);
             
-            child.setUCTVal(currentVal);
+            // the value is only kept for printing the tree, which a shared tree doesn't do
+            if (!_shared)
+            {
+                child.setUCTVal(currentVal);
+            }
 		}
 		else
 		{
@@ -284,6 +715,24 @@ UCTNode & UCTSearch::UCTNodeSelect(UCTNode & parent)
 }
 
 void UCTSearch::updateState(UCTNode & node, GameState & state, bool isLeaf)
+{
+    const bool firstSim(node.getNodeType() == SearchNodeType::FirstSimNode);
+
+    // a first sim node is keyed by the state before its moves, which a leaf makes right away
+    if (_transpositions && firstSim)
+    {
+        findTransposition(node, state);
+    }
+
+    updateState(*_memoryPool, node, state, isLeaf);
+
+    if (_transpositions && !firstSim)
+    {
+        findTransposition(node, state);
+    }
+}
+
+void UCTSearch::updateState(UCTMemoryPool & pool, UCTNode & node, GameState & state, bool isLeaf)
 {
     // if it's the first sim move with children, or the root node
     if ((node.getNodeType() != SearchNodeType::FirstSimNode) || isLeaf)
@@ -292,11 +741,12 @@ void UCTSearch::updateState(UCTNode & node, GameState & state, bool isLeaf)
         if (node.getNodeType() == SearchNodeType::SecondSimNode)
         {
             // make the parent's moves on the state because they haven't been done yet
-            state.makeMoves(node.getParent()->getMove());
+            UCTNode & parent(pool.getParent(node));
+            state.makeMoves(pool.getMove(parent), parent.numActions());
         }
 
         // do the current node moves and call finished moving
-        state.makeMoves(node.getMove());
+        state.makeMoves(pool.getMove(node), node.numActions());
         state.finishedMoving();
     }
 }
@@ -336,6 +786,10 @@ StateEvalScore UCTSearch::traverse(UCTNode & node, GameState & currentState)
             {
                 generateChildren(node, currentState);
             }
+            else if (canWiden(node))
+            {
+                widenChildren(node, currentState);
+            }
 
             UCTNode & next = UCTNodeSelect(node);
             playoutVal = traverse(next, currentState);
@@ -353,6 +807,109 @@ StateEvalScore UCTSearch::traverse(UCTNode & node, GameState & currentState)
         node.addWins(0.5);
     }
 
+    UCTTranspositionTable::Entry * entry(getTransposition(node));
+
+    if (entry)
+    {
+        entry->addVisits(1);
+        entry->addHalfWins((playoutVal.val() > 0) ? 2 : ((playoutVal.val() == 0) ? 1 : 0));
+    }
+
+    return playoutVal;
+}
+
+// The traversal of a tree parallel search. The visit is counted on the way down so that a node
+// another thread is still searching is no longer seen as unvisited, and it counts as a loss for the
+// max player until its result is backed up. A child picked by the min player gets a virtual win
+// for the same reason, so threads which go down at the same time spread out over the tree.
+// The node's transposition table entry gets the same virtual visit and win once its state is known.
+// The first thread to get to an unexpanded node generates its children while the others wait,
+// with progressive widening only one thread at a time adds children to a node
+StateEvalScore UCTSearch::traverseShared(UCTNode & node, GameState & currentState)
+{
+    StateEvalScore playoutVal;
+
+    _results.totalVisits++;
+
+    const bool leaf(node.addVisit() == 0);
+    updateState(node, currentState, leaf);
+
+    UCTTranspositionTable::Entry *  entry(getTransposition(node));
+    const bool                      entryVirtualWin(entry && !isRoot(node) && (node.getPlayer() != _params.maxPlayer()));
+
+    if (entry)
+    {
+        entry->addVisits(1);
+        entry->addHalfWins(entryVirtualWin ? 2 : 0);
+    }
+
+    // if we are the first to visit this node, do a playout
+    if (leaf)
+    {
+        playoutVal = currentState.eval(_params.maxPlayer(), _params.evalMethod(), _params.simScript(Players::Player_One), _params.simScript(Players::Player_Two));
+
+        _results.nodesVisited++;
+    }
+    else
+    {
+        if (currentState.isTerminal())
+        {
+            playoutVal = currentState.eval(_params.maxPlayer(), EvaluationMethods::LTD2);
+        }
+        else
+        {
+            if (!node.isExpanded())
+            {
+                if (node.tryLockExpansion())
+                {
+                    generateChildren(node, currentState);
+                }
+                else
+                {
+                    while (!node.isExpanded())
+                    {
+                        boost::this_thread::yield();
+                    }
+                }
+            }
+            // a thread which doesn't get to widen the node picks from the children it has
+            else if (canWiden(node) && node.tryLockWidening())
+            {
+                widenChildren(node, currentState);
+            }
+
+            UCTNode &   next(UCTNodeSelect(node));
+            const bool  virtualWin(!isRoot(node) && (next.getPlayer() != _params.maxPlayer()));
+
+            if (virtualWin)
+            {
+                next.addHalfWins(2);
+            }
+
+            playoutVal = traverseShared(next, currentState);
+
+            if (virtualWin)
+            {
+                next.removeHalfWins(2);
+            }
+        }
+    }
+
+    if (playoutVal.val() > 0)
+    {
+        node.addHalfWins(2);
+    }
+    else if (playoutVal.val() == 0)
+    {
+        node.addHalfWins(1);
+    }
+
+    if (entry)
+    {
+        entry->removeHalfWins(entryVirtualWin ? 2 : 0);
+        entry->addHalfWins((playoutVal.val() > 0) ? 2 : ((playoutVal.val() == 0) ? 1 : 0));
+    }
+
     return playoutVal;
 }
 
@@ -360,23 +917,138 @@ StateEvalScore UCTSearch::traverse(UCTNode & node, GameState & currentState)
 // state is the GameState after node's moves have been performed
 void UCTSearch::generateChildren(UCTNode & node, GameState & state)
 {
+    // with progressive widening the node only gets its first children now
+    if (_params.wideningConstant() > 0)
+    {
+        _memoryPool->reserveChildren(node, childCapacity(1));
+        widenChildren(node, state);
+        return;
+    }
+
     // figure out who is next to move in the game
     const IDType playerToMove(getPlayerToMove(node, state));
 
     // generate all the moves possible from this state
 	state.generateMoves(_moveArray, playerToMove);
-    _moveArray.shuffleMoveActions();
+    _moveArray.shuffleMoveActions(_random);
 
     // generate the 'ordered moves' for move ordering
     generateOrderedMoves(state, _moveArray, playerToMove);
 
-    // for each child of this state, add a child to the current node
+    _childActions.clear();
+    _childMoveEnds.clear();
+
+    // for each child of this state, add its move to the moves of the children
     for (size_t child(0); (child < _params.maxChildren()) && getNextMove(playerToMove, _moveArray, child, _actionVec); ++child)
     {
-        // add the child to the tree
-        node.addChild(&node, playerToMove, getChildNodeType(node, state), _actionVec, _params.maxChildren(), _memoryPool ? _memoryPool->alloc() : NULL);
+        _childActions.insert(_childActions.end(), _actionVec.begin(), _actionVec.end());
+        _childMoveEnds.push_back(_childActions.size());
         _results.nodesCreated++;
     }
+
+    // add the children to the tree
+    _memoryPool->addChildren(node, playerToMove, getChildNodeType(node, state), _childActions, _childMoveEnds);
+    node.finishExpansion();
+}
+
+// Progressive widening: adds children to the node until it has as many as its visits allow. Only the
+// moves of the new children are computed, in the order generateChildren would give them: a script
+// move per child first, then the move tuples of the MoveArray. The move actions are shuffled with a
+// generator seeded from the state and the node's move, so every call enumerates the tuples in the
+// same order and skipping the ones earlier children were made from finds the next new one
+void UCTSearch::widenChildren(UCTNode & node, GameState & state)
+{
+    // every child of a node is moved by the same player, which may have been picked at random
+    const IDType playerToMove(node.hasChildren() ? _memoryPool->getChild(node, 0).getPlayer() : getPlayerToMove(node, state));
+    const IDType childType((IDType)getChildNodeType(node, state));
+    const size_t allowed(numChildrenAllowed(node));
+    const size_t numOrdered((_params.playerModel(playerToMove) != PlayerModels::None) ? 1 :
+                            ((_params.moveOrderingMethod() == MoveOrderMethod::ScriptFirst) ? _params.getOrderedMoveScripts().size() : 0));
+
+    state.generateMoves(_moveArray, playerToMove);
+    _wideningGen.seed((unsigned int)(state.calculateHash(0) ^ getMoveHash(node, 0)));
+    _moveArray.shuffleMoveActions(&_wideningGen);
+
+    for (size_t c(numOrdered); c < node.numChildren() && _moveArray.hasMoreMoves(); ++c)
+    {
+        _moveArray.getNextMoveVec(_actionVec);
+    }
+
+    bool exhausted(false);
+
+    while (node.numChildren() < allowed)
+    {
+        const size_t child(node.numChildren());
+
+        _actionVec.clear();
+
+        if (child < numOrdered)
+        {
+            if (_params.playerModel(playerToMove) != PlayerModels::None)
+            {
+                _playerModels[playerToMove]->getMoves(state, _moveArray, _actionVec);
+            }
+            else
+            {
+                _allScripts[playerToMove][child]->getMoves(state, _moveArray, _actionVec);
+            }
+        }
+        // a player model only ever gives the node its one move
+        else if (_params.playerModel(playerToMove) == PlayerModels::None && _moveArray.hasMoreMoves())
+        {
+            _moveArray.getNextMoveVec(_actionVec);
+        }
+        else
+        {
+            exhausted = true;
+            break;
+        }
+
+        if (child == childCapacity(child))
+        {
+            _memoryPool->moveChildren(node, childCapacity(child + 1));
+        }
+
+        _memoryPool->addChild(node, playerToMove, childType, _actionVec);
+        _results.nodesCreated++;
+    }
+
+    if (exhausted || node.numChildren() >= _params.maxChildren())
+    {
+        node.finishWidening();
+    }
+    else
+    {
+        node.finishExpansion();
+    }
+}
+
+// whether progressive widening would add a child to an expanded node on this visit
+const bool UCTSearch::canWiden(const UCTNode & node) const
+{
+    return (_params.wideningConstant() > 0) && !node.isWidened() && (node.numChildren() < numChildrenAllowed(node));
+}
+
+// The room the run of children of a widened node has with this many children in it. Runs grow by
+// moving to one twice the size, which a shared tree can't do while other threads are in the subtrees
+// of the children, so there a node gets a run big enough for all of its children right away
+const size_t UCTSearch::childCapacity(const size_t & numChildren) const
+{
+    size_t capacity(1);
+    while (capacity < numChildren)
+    {
+        capacity *= 2;
+    }
+
+    return _shared ? _params.maxChildren() : std::min(capacity, _params.maxChildren());
+}
+
+// the number of children progressive widening gives a node with its visits, at least one
+const size_t UCTSearch::numChildrenAllowed(const UCTNode & node) const
+{
+    const double widened(_params.wideningConstant() * pow((double)node.numVisits(), _params.wideningExponent()));
+
+    return std::min(_params.maxChildren(), std::max((size_t)1, (size_t)widened));
 }
 
 StateEvalScore UCTSearch::performPlayout(GameState & state)
@@ -389,7 +1061,65 @@ StateEvalScore UCTSearch::performPlayout(GameState & state)
 
 const bool UCTSearch::isRoot(UCTNode & node) const
 {
-    return &node == &_rootNode;
+    return &node == _searchRoot;
+}
+
+UCTNode & UCTSearch::mostVisitedChild(UCTNode & node)
+{
+    UCTNode * mostVisitedChild = NULL;
+    double mostVisits = 0;
+    double visits(0);
+    double wins(0);
+
+    for (size_t c(0); c < node.numChildren(); ++c)
+    {
+        UCTNode & child = _memoryPool->getChild(node, c);
+
+        getStats(child, visits, wins);
+
+        if (!mostVisitedChild || (visits > mostVisits))
+        {
+            mostVisitedChild = &child;
+            mostVisits = visits;
+        }
+    }
+
+    return *mostVisitedChild;
+}
+
+UCTNode & UCTSearch::bestUCTValueChild(UCTNode & node, const bool maxPlayer)
+{
+    UCTNode * bestChild = NULL;
+    double bestVal = maxPlayer ? std::numeric_limits<double>::min() : std::numeric_limits<double>::max();
+    double visits(0);
+    double wins(0);
+
+    for (size_t c(0); c < node.numChildren(); ++c)
+    {
+        UCTNode & child = _memoryPool->getChild(node, c);
+
+        getStats(child, visits, wins);
+       
+        double winRate      = wins / visits;
+        double uctVal       = _params.cValue() * sqrt( log( (double)node.numVisits() ) / visits );
+		double currentVal   = maxPlayer ? (winRate + uctVal) : (winRate - uctVal);
+
+        if (maxPlayer)
+        {
+            if (currentVal > bestVal)
+            {
+                bestVal             = currentVal;
+			    bestChild           = &child;
+            }
+        }
+        else if (currentVal < bestVal)
+        {
+            bestVal             = currentVal;
+		    bestChild           = &child;
+        }
+    }
+
+    return *bestChild;
 }
 
 void UCTSearch::printSubTree(UCTNode & node, GameState s, std::string filename)
@@ -414,22 +1144,23 @@ void UCTSearch::printSubTreeGraphViz(UCTNode & node, GraphViz::Graph & g, GameSt
     {
         if (node.getNodeType() == SearchNodeType::SecondSimNode)
         {
-            state.makeMoves(node.getParent()->getMove());
+            UCTNode & parent(_memoryPool->getParent(node));
+            state.makeMoves(_memoryPool->getMove(parent), parent.numActions());
         }
 
-        state.makeMoves(node.getMove());
+        state.makeMoves(_memoryPool->getMove(node), node.numActions());
         state.finishedMoving();
     }
 
     std::stringstream label;
     std::stringstream move;
 
-    for (size_t a(0); a<node.getMove().size(); ++a)
+    for (size_t a(0); a<node.numActions(); ++a)
     {
-        move << node.getMove()[a].moveString() << "\\n";
+        move << _memoryPool->getMove(node)[a].moveString() << "\\n";
     }
 
-    if (node.getMove().size() == 0)
+    if (node.numActions() == 0)
     {
         move << "root";
     }
@@ -476,7 +1207,7 @@ void UCTSearch::printSubTreeGraphViz(UCTNode & node, GraphViz::Graph & g, GameSt
     // recurse for each child
     for (size_t c(0); c<node.numChildren(); ++c)
     {
-        UCTNode & child = node.getChild(c);
+        UCTNode & child = _memoryPool->getChild(node, c);
         if (child.numVisits() > 0)
         {
             GraphViz::Edge edge(getNodeIDString(node), getNodeIDString(child));
@@ -18,6 +18,8 @@
 
 #include <boost/shared_ptr.hpp>
 #include <boost/multi_array.hpp>
+#include <boost/atomic.hpp>
+#include <boost/random/mersenne_twister.hpp>
 
 namespace SparCraft
 {
@@ -30,13 +32,27 @@ class UCTSearch
 	UCTSearchParameters 	_params;
     UCTSearchResults        _results;
 	Timer		            _searchTimer;
-    UCTNode                 _rootNode;
-    UCTMemoryPool *         _memoryPool;
+    UCTNode *               _searchRoot;            // the root of the tree being searched, shared by tree parallel threads
+    UCTMemoryPool *         _memoryPool;            // holds the tree, set by the caller to keep it between searches
+    boost::shared_ptr<UCTMemoryPool> _ownPool;       // used if the caller doesn't set one
+    UCTMemoryPool *         _previousPool;          // the tree of the previous search to keep the subtree of our state from
+    const GameState *       _previousState;         // the state the previous search started from
+    UCTTranspositionTable * _transpositions;        // statistics shared by the nodes of the same state, NULL if not used
+
+    // parallel search state, a thread of a parallel search uses its own generator for the random
+    // choices. Threads of a tree parallel search share the tree and the count of traversals left
+    bool                    _shared;
+    boost::random::mt19937  _gen;
+    boost::random::mt19937 * _random;
+    boost::random::mt19937  _wideningGen;           // shuffles the moves of a node the same way every time it is widened
+    boost::atomic<size_t> * _traversalCounter;
 
     GameState               _currentState;
 
 	// we will use these as variables to save stack allocation every time
     std::vector<UnitAction>                 _actionVec;
+    std::vector<UnitAction>                 _childActions;
+    std::vector<size_t>                     _childMoveEnds;
 	MoveArray                               _moveArray;
 	Array<std::vector<UnitAction>,
 		 Constants::Max_Ordered_Moves>      _orderedMoves;
@@ -55,9 +71,35 @@ public:
 	void            uct(GameState & state, size_t depth, const IDType lastPlayerToMove, std::vector<UnitAction> * firstSimMove);
 
 	void            doSearch(GameState & initialState, std::vector<UnitAction> & move);
+    void            doTraversals(GameState & initialState, Timer & timer);
+
+    // parallel searches
+    void            doRootParallelSearch(GameState & initialState, Timer & timer);
+    void            doTreeParallelSearch(GameState & initialState, Timer & timer);
+    void            doSharedTraversals(GameState & initialState, Timer timer);
+    StateEvalScore  traverseShared(UCTNode & node, GameState & currentState);
+    void            mergeRootChildren(std::vector< boost::shared_ptr<UCTSearch> > & searches);
+    void            addResults(const UCTSearchResults & results);
+    void            setRandomSeed(const unsigned int & seed);
+
+    // tree reuse
+    void            setPreviousTree(UCTMemoryPool * pool, const GameState & state);
+    UCTNode *       retainTree(const GameState & initialState);
+    void            findState(UCTNode & node, GameState & state, const GameState & target, const HashType & targetHash, UCTNode * & found);
+
+    // transpositions
+    void            findTransposition(UCTNode & node, const GameState & state);
+    void            addTranspositions(UCTNode & node, GameState & state);
+    UCTTranspositionTable::Entry * getTransposition(const UCTNode & node);
+    void            getStats(const UCTNode & node, double & visits, double & wins);
+    const HashType  getMoveHash(const UCTNode & node, const size_t & hashNum) const;
     
     // Move and Child generation functions
     void            generateChildren(UCTNode & node, GameState & state);
+    void            widenChildren(UCTNode & node, GameState & state);
+    const bool      canWiden(const UCTNode & node) const;
+    const size_t    numChildrenAllowed(const UCTNode & node) const;
+    const size_t    childCapacity(const size_t & numChildren) const;
 	void            generateOrderedMoves(GameState & state, MoveArray & moves, const IDType & playerToMove);
     void            makeMove(UCTNode & node, GameState & state);
 	const bool      getNextMove(IDType playerToMove, MoveArray & moves, const size_t & moveNumber, std::vector<UnitAction> & actionVec);
@@ -67,11 +109,14 @@ public:
     const size_t    getChildNodeType(UCTNode & parent, const GameState & prevState) const;
 	const bool      searchTimeOut();
 	const bool      isRoot(UCTNode & node) const;
+    UCTNode &       mostVisitedChild(UCTNode & node);
+    UCTNode &       bestUCTValueChild(UCTNode & node, const bool maxPlayer);
 	const bool      terminalState(GameState & state, const size_t & depth) const;
     const bool      isFirstSimMove(UCTNode & node, GameState & state);
     const bool      isSecondSimMove(UCTNode & node, GameState & state);
     StateEvalScore  performPlayout(GameState & state);
     void            updateState(UCTNode & node, GameState & state, bool isLeaf);
+    void            updateState(UCTMemoryPool & pool, UCTNode & node, GameState & state, bool isLeaf);
     void            setMemoryPool(UCTMemoryPool * pool);
     UCTSearchResults & getResults();
 
@@ -26,6 +26,12 @@ class SparCraft::UCTSearchParameters
     IDType          _simScripts[2];                 // NOKDPS               Policy to use for playouts
 	IDType		    _playerToMoveMethod;		    // Alternate			The player to move policy
 	IDType		    _playerModel[2];                // None                 Player model to use for each player
+    IDType          _parallelMethod;                // None                 How the traversals are split over threads
+    size_t          _numThreads;                    // 1                    Number of search threads
+    bool            _reuseTree;                     // false                Start from the previous search's subtree of the state
+    size_t          _transpositionTableSize;        // 0                    Entries of the table sharing statistics between transpositions, 0 means none
+    double          _wideningConstant;              // 0                    Progressive widening gives a node C * visits^exponent children, 0 means all at once
+    double          _wideningExponent;              // 0.5                  Exponent of the progressive widening schedule
 
     std::string     _graphVizFilename;              // ""                   File name to output graph viz file
 
@@ -46,6 +52,12 @@ public:
         , _moveOrdering         (MoveOrderMethod::ScriptFirst)
         , _evalMethod           (SparCraft::EvaluationMethods::Playout)
 	    , _playerToMoveMethod   (SparCraft::PlayerToMove::Alternate)
+        , _parallelMethod       (ParallelMethods::None)
+        , _numThreads           (1)
+        , _reuseTree            (false)
+        , _transpositionTableSize (0)
+        , _wideningConstant     (0)
+        , _wideningExponent     (0.5)
     {
 	    setPlayerModel(Players::Player_One, PlayerModels::None);
 	    setPlayerModel(Players::Player_Two, PlayerModels::None);
@@ -65,6 +77,12 @@ public:
     const IDType & rootMoveSelectionMethod()                    const   { return _rootMoveSelection; }
     const std::string & graphVizFilename()                      const   { return _graphVizFilename; }
     const std::vector<IDType> & getOrderedMoveScripts()         const   { return _orderedMoveScripts; }
+    const IDType & parallelMethod()                             const   { return _parallelMethod; }
+    const size_t & numThreads()                                 const   { return _numThreads; }
+    const bool & reuseTree()                                    const   { return _reuseTree; }
+    const size_t & transpositionTableSize()                     const   { return _transpositionTableSize; }
+    const double & wideningConstant()                           const   { return _wideningConstant; }
+    const double & wideningExponent()                           const   { return _wideningExponent; }
 	
     void setMaxPlayer(const IDType & player)					        { _maxPlayer = player; }
     void setTimeLimit(const size_t & timeLimit)					        { _timeLimit = timeLimit; }  
@@ -79,6 +97,11 @@ public:
     void setGraphVizFilename(const std::string & filename)              { _graphVizFilename = filename; }
     void addOrderedMoveScript(const IDType & script)                    { _orderedMoveScripts.push_back(script); }
     void setPlayerModel(const IDType & player, const IDType & model)	{ _playerModel[player] = model; }	
+    void setParallelMethod(const IDType & method)                       { _parallelMethod = method; }
+    void setNumThreads(const size_t & threads)                          { _numThreads = threads; }
+    void setReuseTree(const bool & reuse)                               { _reuseTree = reuse; }
+    void setTranspositionTableSize(const size_t & entries)              { _transpositionTableSize = entries; }
+    void setWidening(const double & constant, const double & exponent)  { _wideningConstant = constant; _wideningExponent = exponent; }
 
     std::vector<std::vector<std::string> > & getDescription()
     {
@@ -97,6 +120,11 @@ public:
             _desc[0].push_back("Move Ordering:");
             _desc[0].push_back("Player To Move:");
             _desc[0].push_back("Opponent Model:");
+            _desc[0].push_back("Parallel Method:");
+            _desc[0].push_back("Threads:");
+            _desc[0].push_back("Reuse Tree:");
+            _desc[0].push_back("Transposition Table:");
+            _desc[0].push_back("Widening:");
 
             ss << "UCT";                                                _desc[1].push_back(ss.str()); ss.str(std::string());
             ss << timeLimit() << "ms";                                  _desc[1].push_back(ss.str()); ss.str(std::string());
@@ -106,6 +134,20 @@ public:
             ss << MoveOrderMethod::getName(moveOrderingMethod());         _desc[1].push_back(ss.str()); ss.str(std::string());
             ss << PlayerToMove::getName(playerToMoveMethod());            _desc[1].push_back(ss.str()); ss.str(std::string());
             ss << PlayerModels::getName(playerModel((maxPlayer()+1)%2));  _desc[1].push_back(ss.str()); ss.str(std::string());
+            ss << ParallelMethods::getName(parallelMethod());             _desc[1].push_back(ss.str()); ss.str(std::string());
+            ss << numThreads();                                           _desc[1].push_back(ss.str()); ss.str(std::string());
+            ss << (reuseTree() ? "true" : "false");                       _desc[1].push_back(ss.str()); ss.str(std::string());
+            ss << transpositionTableSize();                               _desc[1].push_back(ss.str()); ss.str(std::string());
+
+            if (wideningConstant() > 0)
+            {
+                ss << wideningConstant() << " n^" << wideningExponent();
+            }
+            else
+            {
+                ss << "None";
+            }
+            _desc[1].push_back(ss.str()); ss.str(std::string());
         }
         
         return _desc;
@@ -18,6 +18,8 @@ public:
     int                         nodesVisited;
     int                         totalVisits;
     int                         nodesCreated;
+    int                         retainedVisits;     // visits kept from the previous search's tree
+    int                         transpositions;     // nodes whose state another node had already reached
 
     std::vector<UnitAction>     bestMoves;
 	ScoreType                   abValue;
@@ -32,6 +34,8 @@ public:
         , nodesVisited          (0)
         , totalVisits           (0)
         , nodesCreated          (0)
+        , retainedVisits        (0)
+        , transpositions        (0)
 		, abValue               (0)
 	{
 	}
@@ -48,11 +52,15 @@ public:
         _desc[0].push_back("Nodes Visited: ");
         _desc[0].push_back("Total Visits: ");
         _desc[0].push_back("Nodes Created: ");
+        _desc[0].push_back("Retained Visits: ");
+        _desc[0].push_back("Transpositions: ");
 
         ss << traversals;       _desc[1].push_back(ss.str()); ss.str(std::string());
         ss << nodesVisited;     _desc[1].push_back(ss.str()); ss.str(std::string());
         ss << totalVisits;      _desc[1].push_back(ss.str()); ss.str(std::string());
         ss << nodesCreated;     _desc[1].push_back(ss.str()); ss.str(std::string());
+        ss << retainedVisits;   _desc[1].push_back(ss.str()); ss.str(std::string());
+        ss << transpositions;   _desc[1].push_back(ss.str()); ss.str(std::string());
         
         return _desc;
     }
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Common.h"
+
+#include <boost/atomic.hpp>
+
+namespace SparCraft
+{
+    class UCTTranspositionTable;
+}
+
+// The statistics of the states of a UCT tree, shared by all the nodes which reach the same state
+// through different move orders. An entry is found from the first hash of a state and checked with
+// the second one, it is claimed by the first node to look it up and never replaced during a search,
+// so once the table can't find a free entry within Max_Probes slots a node just keeps its own
+// statistics. Entries are claimed with a compare and swap, so the threads of a tree parallel search
+// can share the table
+class SparCraft::UCTTranspositionTable
+{
+public:
+
+    enum { No_Entry = 0xFFFFFFFE, Max_Probes = 4 };
+
+    class Entry
+    {
+        boost::atomic<unsigned int>     _check;             // second hash of the state, 0 if the entry is free
+        boost::atomic<unsigned int>     _numVisits;
+        boost::atomic<unsigned int>     _numHalfWins;
+
+        friend class UCTTranspositionTable;
+
+    public:
+
+        Entry()
+            : _check        (0)
+            , _numVisits    (0)
+            , _numHalfWins  (0)
+        {
+        }
+
+        const size_t    numVisits()                 const   { return _numVisits.load(boost::memory_order_relaxed); }
+        const double    numWins()                   const   { return 0.5 * _numHalfWins.load(boost::memory_order_relaxed); }
+
+        void            addVisits(const size_t & visits)    { _numVisits.fetch_add((unsigned int)visits, boost::memory_order_relaxed); }
+        void            addHalfWins(const size_t & halfWins) { _numHalfWins.fetch_add((unsigned int)halfWins, boost::memory_order_relaxed); }
+        void            removeHalfWins(const size_t & halfWins) { _numHalfWins.fetch_sub((unsigned int)halfWins, boost::memory_order_relaxed); }
+    };
+
+private:
+
+    Entry *         _entries;
+    size_t          _size;
+
+    UCTTranspositionTable(const UCTTranspositionTable & rhs);
+    UCTTranspositionTable & operator = (const UCTTranspositionTable & rhs);
+
+public:
+
+    UCTTranspositionTable()
+        : _entries  (NULL)
+        , _size     (0)
+    {
+    }
+
+    ~UCTTranspositionTable()
+    {
+        delete [] _entries;
+    }
+
+    // sets the table to the largest power of two number of entries up to size and clears it
+    void resize(const size_t & size)
+    {
+        size_t powerOfTwo(1);
+        while (powerOfTwo * 2 <= size)
+        {
+            powerOfTwo *= 2;
+        }
+
+        if (powerOfTwo != _size)
+        {
+            delete [] _entries;
+            _entries = new Entry[powerOfTwo];
+            _size = powerOfTwo;
+        }
+        else
+        {
+            clear();
+        }
+    }
+
+    void clear()
+    {
+        for (size_t i(0); i < _size; ++i)
+        {
+            _entries[i]._check.store(0, boost::memory_order_relaxed);
+            _entries[i]._numVisits.store(0, boost::memory_order_relaxed);
+            _entries[i]._numHalfWins.store(0, boost::memory_order_relaxed);
+        }
+    }
+
+    // the index of the entry of the state with these hashes, claiming a free one if the state isn't
+    // in the table yet. found says whether it was already there. Returns No_Entry if the table is full
+    const unsigned int find(const HashType & hash1, const HashType & hash2, bool & found)
+    {
+        const unsigned int check(hash2 ? (unsigned int)hash2 : 1);
+
+        for (size_t p(0); p < Max_Probes; ++p)
+        {
+            const size_t    index((hash1 + p) & (_size - 1));
+            unsigned int    current(_entries[index]._check.load(boost::memory_order_relaxed));
+
+            if (current == 0 && _entries[index]._check.compare_exchange_strong(current, check, boost::memory_order_relaxed))
+            {
+                found = false;
+                return (unsigned int)index;
+            }
+
+            // if another thread claimed the entry first it is now in current
+            if (current == check)
+            {
+                found = true;
+                return (unsigned int)index;
+            }
+        }
+
+        return No_Entry;
+    }
+
+    Entry &         getEntry(const unsigned int & index)            { return _entries[index]; }
+    const size_t    size()                                  const   { return _size; }
+};
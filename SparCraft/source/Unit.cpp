@@ -1,37 +1,47 @@
 #include "Unit.h"
+#include "CombatTables.h"
 
 using namespace SparCraft;
 
-Unit::Unit()
-    : _unitType             (BWAPI::UnitTypes::None)
-    , _range                (0)
-    , _unitID               (255)
-    , _playerID             (255)
-    , _currentHP            (0)
-    , _currentEnergy        (0)
-    , _timeCanMove          (0)
-    , _timeCanAttack        (0)
-    , _previousActionTime   (0)
-    , _prevCurrentPosTime   (0)
+const Unit Unit::Empty()
 {
-    
+    Unit unit;
+
+    unit._x                     = 0;
+    unit._y                     = 0;
+    unit._timeCanMove           = 0;
+    unit._timeCanAttack         = 0;
+    unit._previousActionTime    = 0;
+    unit._currentHP             = 0;
+    unit._previousDX            = 0;
+    unit._previousDY            = 0;
+    unit._typeID                = (unsigned char)BWAPI::UnitTypes::None.getID();
+    unit._unitID                = Constants::No_ID;
+    unit._playerID              = Constants::No_ID;
+    unit._currentEnergy         = 0;
+    unit._previousActionType    = UnitActionTypes::NONE;
+    unit._previousActionIndex   = Constants::No_ID;
+
+    return unit;
 }
 
 // test constructor for setting all variables of a unit
 Unit::Unit(const BWAPI::UnitType unitType, const Position & pos, const IDType & unitID, const IDType & playerID, 
            const HealthType & hp, const HealthType & energy, const TimeType & tm, const TimeType & ta) 
-    : _unitType             (unitType)
-    , _range                (PlayerWeapon(&PlayerProperties::Get(playerID), unitType.groundWeapon()).GetMaxRange() + Constants::Range_Addition)
-    //, _range                (unitType.groundWeapon().maxRange() + Constants::Range_Addition)
-    , _position             (pos)
-    , _unitID               (unitID)
-    , _playerID             (playerID)
-    , _currentHP            (hp)
-    , _currentEnergy        (energy)
+    : _x                    (pos.x())
+    , _y                    (pos.y())
     , _timeCanMove          (tm)
     , _timeCanAttack        (ta)
     , _previousActionTime   (0)
-    , _prevCurrentPosTime   (0)
+    , _currentHP            (hp)
+    , _previousDX           (0)
+    , _previousDY           (0)
+    , _typeID               ((unsigned char)unitType.getID())
+    , _unitID               (unitID)
+    , _playerID             (playerID)
+    , _currentEnergy        ((unsigned char)energy)
+    , _previousActionType   (UnitActionTypes::NONE)
+    , _previousActionIndex  (Constants::No_ID)
 {
     System::checkSupportedUnitType(unitType);
 }
@@ -55,20 +65,20 @@ Unit::Unit(const BWAPI::UnitType unitType, const Position & pos, const IDType &
 
 // constructor for units to construct basic units, sets some things automatically
 Unit::Unit(const BWAPI::UnitType unitType, const IDType & playerID, const Position & pos) 
-    : _unitType             (unitType)
-    , _range                (PlayerWeapon(&PlayerProperties::Get(playerID), unitType.groundWeapon()).GetMaxRange() + Constants::Range_Addition)
-    //, _range                (unitType.groundWeapon().maxRange() + Constants::Range_Addition)
-    , _position             (pos)
-    , _unitID               (0)
-    , _playerID             (playerID)
-    , _currentHP            (maxHP())
-    , _currentEnergy        (unitType == BWAPI::UnitTypes::Terran_Medic ? Constants::Starting_Energy : 0)
+    : _x                    (pos.x())
+    , _y                    (pos.y())
     , _timeCanMove          (0)
     , _timeCanAttack        (0)
     , _previousActionTime   (0)
-    , _prevCurrentPosTime   (0)
-    , _previousPosition     (pos)
-    , _prevCurrentPos       (pos)
+    , _currentHP            ((HealthType)unitType.maxHitPoints() + (HealthType)unitType.maxShields())
+    , _previousDX           (0)
+    , _previousDY           (0)
+    , _typeID               ((unsigned char)unitType.getID())
+    , _unitID               (0)
+    , _playerID             (playerID)
+    , _currentEnergy        (unitType == BWAPI::UnitTypes::Terran_Medic ? Constants::Starting_Energy : 0)
+    , _previousActionType   (UnitActionTypes::NONE)
+    , _previousActionIndex  (Constants::No_ID)
 {
     System::checkSupportedUnitType(unitType);
 }
@@ -125,18 +135,13 @@ const bool Unit::equalsID(const Unit & rhs) const
 // returns whether or not this unit can attack a given unit at a given time
 const bool Unit::canAttackTarget(const Unit & unit, const TimeType & gameTime) const
 {
-    BWAPI::WeaponType weapon = unit.type().isFlyer() ? type().airWeapon() : type().groundWeapon();
-
-    if (weapon.damageAmount() == 0)
+    if (!CombatTables::canAttack(typeID(), unit.typeID()))
     {
         return false;
     }
 
-    // range of this unit attacking
-    PositionType r = range();
-
     // return whether the target unit is in range
-    return (r * r) >= getDistanceSqToUnit(unit, gameTime);
+    return CombatTables::getRangeSq(typeID(), player()) >= getDistanceSqToUnit(unit, gameTime);
 }
 
 const bool Unit::canHealTarget(const Unit & unit, const TimeType & gameTime) const
@@ -155,29 +160,15 @@ const bool Unit::canHealTarget(const Unit & unit, const TimeType & gameTime) con
     return (r * r) >= getDistanceSqToUnit(unit, gameTime);
 }
 
-const Position & Unit::position() const
+const Position Unit::position() const
 {
-    return _position;
+    return Position(_x, _y);
 }
 
 // take an attack, subtract the hp
 void Unit::takeAttack(const Unit & attacker)
 {
-    PlayerWeapon    weapon(attacker.getWeapon(*this));
-    HealthType      damage(weapon.GetDamageBase());
-
-    // calculate the damage based on armor and damage types
-    damage = std::max((int)((damage-getArmor()) * weapon.GetDamageMultiplier(getSize())), 2);
-    
-    // special case where units attack multiple times
-    if (attacker.type() == BWAPI::UnitTypes::Protoss_Zealot || attacker.type() == BWAPI::UnitTypes::Terran_Firebat)
-    {
-        damage *= 2;
-    }
-
-    std::cout << type().getName() << " took " << (int)attacker.player() << " " << damage << "\n";
-
-    updateCurrentHP(_currentHP - damage);
+    updateCurrentHP(_currentHP - attacker.getDamageTo(*this));
 }
 
 void Unit::takeHeal(const Unit & healer)
@@ -195,7 +186,7 @@ const bool Unit::isAlive() const
 void Unit::attack(const UnitAction & move, const Unit & target, const TimeType & gameTime)
 {
     // if this is a repeat attack
-    if (_previousAction.type() == UnitActionTypes::ATTACK || _previousAction.type() == UnitActionTypes::RELOAD)
+    if (_previousActionType == UnitActionTypes::ATTACK || _previousActionType == UnitActionTypes::RELOAD)
     {
         // add the repeat attack animation duration
         // can't attack again until attack cooldown is up
@@ -203,7 +194,7 @@ void Unit::attack(const UnitAction & move, const Unit & target, const TimeType &
         updateAttackActionTime    (gameTime + attackCooldown());
     }
     // if there previous action was a MOVE action, add the move penalty
-    else if (_previousAction.type() == UnitActionTypes::MOVE)
+    else if (_previousActionType == UnitActionTypes::MOVE)
     {
         updateMoveActionTime      (gameTime + attackInitFrameTime() + 2);
         updateAttackActionTime    (gameTime + attackCooldown() + Constants::Move_Penalty);
@@ -244,7 +235,7 @@ void Unit::heal(const UnitAction & move, const Unit & target, const TimeType & g
 // unit update for moving based on a given Move
 void Unit::move(const UnitAction & move, const TimeType & gameTime) 
 {
-    _previousPosition = pos();
+    const Position previous(pos());
 
     // get the distance to the move action destination
     PositionType dist = move.pos().getDistance(pos());
@@ -259,8 +250,10 @@ void Unit::move(const UnitAction & move, const TimeType & gameTime)
     updateAttackActionTime(std::max(nextAttackActionTime(), nextMoveActionTime()));
 
     // update the position
-    //_position.addPosition(dist * dir.x(), dist * dir.y());
-    _position.moveTo(move.pos());
+    _x = move.pos().x();
+    _y = move.pos().y();
+    _previousDX = (short)(previous.x() - _x);
+    _previousDY = (short)(previous.y() - _y);
 
     setPreviousAction(move, gameTime);
 }
@@ -291,63 +284,48 @@ const PositionType Unit::getDistanceSqToPosition(const Position & p, const TimeT
 }
 
 // returns current position based on game time
-const Position & Unit::currentPosition(const TimeType & gameTime) const
+const Position Unit::currentPosition(const TimeType & gameTime) const
 {
     // if the previous move was MOVE, then we need to calculate where the unit is now
-    if (_previousAction.type() == UnitActionTypes::MOVE)
+    if (_previousActionType == UnitActionTypes::MOVE)
     {
         // if gameTime is equal to previous move time then we haven't moved yet
         if (gameTime == _previousActionTime)
         {
-            return _previousPosition;
+            return previousPosition();
         }
         // else if game time is >= time we can move, then we have arrived at the destination
         else if (gameTime >= _timeCanMove)
         {
-            return _position;
+            return pos();
         }
         // otherwise we are still moving, so calculate the current position
-        else if (gameTime == _prevCurrentPosTime)
-        {
-            return _prevCurrentPos;
-        }
         else
         {
             TimeType moveDuration = _timeCanMove - _previousActionTime;
             float moveTimeRatio = (float)(gameTime - _previousActionTime) / moveDuration;
-            _prevCurrentPosTime = gameTime;
+            const Position previous(previousPosition());
 
             // calculate the new current position
-            _prevCurrentPos = _position;
-            _prevCurrentPos.subtractPosition(_previousPosition);
-            _prevCurrentPos.scalePosition(moveTimeRatio);
-            _prevCurrentPos.addPosition(_previousPosition);
+            Position current(pos());
+            current.subtractPosition(previous);
+            current.scalePosition(moveTimeRatio);
+            current.addPosition(previous);
 
-            //_prevCurrentPos = _previousPosition + (_position - _previousPosition).scale(moveTimeRatio);
-            return _prevCurrentPos;
+            return current;
         }
     }
     // if it wasn't a MOVE, then we just return the Unit position
     else
     {
-        return _position;
+        return pos();
     }
 }
 
-void Unit::setPreviousPosition(const TimeType & gameTime)
-{
-    TimeType moveDuration = _timeCanMove - _previousActionTime;
-    float moveTimeRatio = (float)(gameTime - _previousActionTime) / moveDuration;
-    _prevCurrentPosTime = gameTime;
-    _prevCurrentPos = _previousPosition + (_position - _previousPosition).scale(moveTimeRatio);
-}
-
 // returns the damage a unit does
 const HealthType Unit::damage() const	
 { 
-    return _unitType == BWAPI::UnitTypes::Protoss_Zealot ? 
-        2 * (HealthType)_unitType.groundWeapon().damageAmount() : 
-    (HealthType)_unitType.groundWeapon().damageAmount(); 
+    return CombatTables::getGroundDamage(typeID()); 
 }
 
 const HealthType Unit::healAmount() const
@@ -357,7 +335,7 @@ const HealthType Unit::healAmount() const
 
 void Unit::print() const 
 { 
-    printf("%s %5d [%5d %5d] (%5d, %5d)\n", _unitType.getName().c_str(), currentHP(), nextAttackActionTime(), nextMoveActionTime(), x(), y()); 
+    printf("%s %5d [%5d %5d] (%5d, %5d)\n", type().getName().c_str(), currentHP(), nextAttackActionTime(), nextMoveActionTime(), x(), y()); 
 }
 
 void Unit::updateCurrentHP(const HealthType & newHP) 
@@ -388,7 +366,8 @@ void Unit::setUnitID(const IDType & id)
 void Unit::setPreviousAction(const UnitAction & m, const TimeType & previousMoveTime) 
 {	
     // if it was an attack move, store the unitID of the opponent unit
-    _previousAction = m;
+    _previousActionType = m.type();
+    _previousActionIndex = m.index();
     _previousActionTime = previousMoveTime; 
 }
 
@@ -414,17 +393,17 @@ const bool Unit::canKite() const
 
 const bool Unit::isMobile() const
 { 
-    return _unitType.canMove(); 
+    return CombatTables::getCanMove(typeID()); 
 }
 
 const bool Unit::canHeal() const
 { 
-    return _unitType == BWAPI::UnitTypes::Terran_Medic; 
+    return typeID() == BWAPI::UnitTypes::Terran_Medic.getID(); 
 }
 
 const bool Unit::isOrganic() const
 { 
-    return _unitType.isOrganic(); 
+    return type().isOrganic(); 
 }
 
 const IDType Unit::ID() const	
@@ -437,24 +416,29 @@ const IDType Unit::player() const
     return _playerID; 
 }
 
-const Position & Unit::pos() const
+const Position Unit::pos() const
 { 
-    return _position; 
+    return Position(_x, _y); 
+}
+
+const Position Unit::previousPosition() const
+{ 
+    return Position(_x + _previousDX, _y + _previousDY); 
 }
 
 const PositionType Unit::x() const 
 { 
-    return _position.x(); 
+    return _x; 
 }
 
 const PositionType Unit::y() const 
 { 
-    return _position.y(); 
+    return _y; 
 }
 
 const PositionType Unit::range() const 
 { 
-    return _range; 
+    return CombatTables::getRange(typeID(), player()); 
 }
 
 const PositionType Unit::healRange() const
@@ -464,7 +448,7 @@ const PositionType Unit::healRange() const
 
 const HealthType Unit::maxHP() const 
 { 
-    return (HealthType)_unitType.maxHitPoints() + (HealthType)_unitType.maxShields(); 
+    return (HealthType)type().maxHitPoints() + (HealthType)type().maxShields(); 
 }
 
 const HealthType Unit::currentHP() const 
@@ -479,7 +463,7 @@ const HealthType Unit::currentEnergy() const
 
 const HealthType Unit::maxEnergy() const
 { 
-    return (HealthType)_unitType.maxEnergy(); 
+    return (HealthType)type().maxEnergy(); 
 }
 
 const HealthType Unit::healCost() const	
@@ -489,17 +473,17 @@ const HealthType Unit::healCost() const
 
 const float Unit::dpf() const 
 { 
-    return (float)std::max(Constants::Min_Unit_DPF, (float)damage() / ((float)attackCooldown() + 1)); 
+    return CombatTables::getDPF(typeID()); 
 }
 
 const TimeType Unit::moveCooldown() const 
 { 
-    return (TimeType)((double)Constants::Move_Distance / _unitType.topSpeed()); 
+    return (TimeType)((double)Constants::Move_Distance / type().topSpeed()); 
 }
 
 const TimeType Unit::attackCooldown() const 
 { 
-    return (TimeType)_unitType.groundWeapon().damageCooldown(); 
+    return CombatTables::getCooldown(typeID()); 
 }
 
 const TimeType Unit::healCooldown() const 
@@ -529,87 +513,117 @@ const TimeType Unit::firstTimeFree() const
 
 const TimeType Unit::attackInitFrameTime() const	
 { 
-    return AnimationFrameData::getAttackFrames(_unitType).first; 
+    return CombatTables::getAttackInitFrames(typeID()); 
 }
 
 const TimeType Unit::attackRepeatFrameTime() const	
 {
-    return AnimationFrameData::getAttackFrames(_unitType).second; 
+    return CombatTables::getAttackRepeatFrames(typeID()); 
 }
 
 const int Unit::typeID() const	
 { 
-    return _unitType.getID(); 
+    return _typeID; 
 }
 
 const double Unit::speed() const 
 { 
-    return _unitType.topSpeed(); 
+    return type().topSpeed(); 
 }
 
 const BWAPI::UnitType Unit::type() const 
 { 
-    return _unitType; 
+    return BWAPI::UnitType(_typeID); 
 }
 
-const UnitAction & Unit::previousAction() const 
+// the unit index and player of the action aren't kept, they are this unit's
+const UnitAction Unit::previousAction() const 
 { 
-    return _previousAction; 
+    if (_previousActionType == UnitActionTypes::MOVE)
+    {
+        return UnitAction(Constants::No_ID, _playerID, _previousActionType, _previousActionIndex, pos());
+    }
+
+    return UnitAction(Constants::No_ID, _playerID, _previousActionType, _previousActionIndex);
 }
 
 const BWAPI::UnitSizeType Unit::getSize() const
 {
-    return _unitType.size();
+    return type().size();
 }
 
 const PlayerWeapon Unit::getWeapon(const Unit & target) const
 {
-    return PlayerWeapon(&PlayerProperties::Get(player()), target.type().isFlyer() ? _unitType.airWeapon() : _unitType.groundWeapon());
+    return PlayerWeapon(&PlayerProperties::Get(player()), target.type().isFlyer() ? type().airWeapon() : type().groundWeapon());
 }
 
 const HealthType Unit::getArmor() const
 {
-    return UnitProperties::Get(type()).GetArmor(PlayerProperties::Get(player())); 
+    return CombatTables::getArmor(typeID(), player()); 
+}
+
+// damage this unit does to the given unit with one attack, after upgrades, armor and damage types
+const HealthType Unit::getDamageTo(const Unit & unit) const
+{
+    return CombatTables::getDamage(typeID(), player(), unit.typeID(), unit.player());
 }
 
 const BWAPI::WeaponType Unit::getWeapon(BWAPI::UnitType target) const
 {
-    return target.isFlyer() ? _unitType.airWeapon() : _unitType.groundWeapon();
+    return target.isFlyer() ? type().airWeapon() : type().groundWeapon();
 }
 
 const std::string Unit::name() const 
 { 
-    std::string n(_unitType.getName());
+    std::string n(type().getName());
     std::replace(n.begin(), n.end(), ' ', '_');
     return n;
 }
 
-// calculates the hash of this unit based on a given game time
-const HashType Unit::calculateHash(const size_t & hashNum, const TimeType & gameTime) const
+// calculates the hash of the parts of this unit which do not depend on game time
+// a moving unit is hashed by where it came from and where it is going, which together
+// with the time hash determines its current position at any game time
+const HashType Unit::calculateHash(const size_t & hashNum) const
 {
-    Position currentPos = currentPosition(gameTime);
+    HashType hash =   Hash::values[hashNum].getUnitIDHash(_playerID, _unitID)
+                    ^ Hash::values[hashNum].positionHash(_playerID, _x, _y) 
+                    ^ Hash::values[hashNum].getCurrentHPHash(_playerID, currentHP())
+                    ^ Hash::values[hashNum].getUnitTypeHash(_playerID, typeID());
+
+    if (_previousActionType == UnitActionTypes::MOVE)
+    {
+        hash ^= Hash::values[hashNum].getPreviousPositionHash(_playerID, _x + _previousDX, _y + _previousDY);
+    }
+
+    return Hash::hash32shift(hash);
+}
+
+// calculates the hash of the absolute times of this unit
+// these are summed rather than xor-ed so the GameState can make them relative to its current time
+const HashType Unit::calculateTimeHash(const size_t & hashNum) const
+{
+    HashType hash =   Hash::values[hashNum].getAttackTimeHash(_playerID, _unitID, nextAttackActionTime())
+                    + Hash::values[hashNum].getMoveTimeHash(_playerID, _unitID, nextMoveActionTime());
+
+    if (_previousActionType == UnitActionTypes::MOVE)
+    {
+        hash += Hash::values[hashNum].getActionTimeHash(_playerID, _unitID, previousActionTime());
+    }
 
-    return	  Hash::values[hashNum].positionHash(_playerID, currentPos.x(), currentPos.y()) 
-            ^ Hash::values[hashNum].getAttackHash(_playerID, nextAttackActionTime() - gameTime) 
-            ^ Hash::values[hashNum].getMoveHash(_playerID, nextMoveActionTime() - gameTime)
-            ^ Hash::values[hashNum].getCurrentHPHash(_playerID, currentHP())
-            ^ Hash::values[hashNum].getUnitTypeHash(_playerID, typeID());
+    return hash;
 }
 
-// calculates the hash of this unit based on a given game time, and prints debug info
-void Unit::debugHash(const size_t & hashNum, const TimeType & gameTime) const
+// prints the components of the unit hash
+void Unit::debugHash(const size_t & hashNum) const
 {
+    std::cout << " ID    " << Hash::values[hashNum].getUnitIDHash(_playerID, _unitID);
     std::cout << " Pos   " << Hash::values[hashNum].positionHash(_playerID, position().x(), position().y());
-    std::cout << " Att   " << Hash::values[hashNum].getAttackHash(_playerID, nextAttackActionTime() - gameTime);
-    std::cout << " Mov   " << Hash::values[hashNum].getMoveHash(_playerID, nextMoveActionTime() - gameTime);
     std::cout << " HP    " << Hash::values[hashNum].getCurrentHPHash(_playerID, currentHP());
-    std::cout << " Typ   " << Hash::values[hashNum].getUnitTypeHash(_playerID, typeID()) << "\n";;
+    std::cout << " Typ   " << Hash::values[hashNum].getUnitTypeHash(_playerID, typeID());
+    std::cout << " Att   " << Hash::values[hashNum].getAttackTimeHash(_playerID, _unitID, nextAttackActionTime());
+    std::cout << " Mov   " << Hash::values[hashNum].getMoveTimeHash(_playerID, _unitID, nextMoveActionTime()) << "\n";
 
-    HashType hash = Hash::values[hashNum].positionHash(_playerID, position().x(), position().y()); std::cout << hash << "\n";
-    hash ^= Hash::values[hashNum].getAttackHash(_playerID, nextAttackActionTime() - gameTime) ; std::cout << hash << "\n";
-    hash ^= Hash::values[hashNum].getMoveHash(_playerID, nextMoveActionTime() - gameTime); std::cout << hash << "\n";
-    hash ^= Hash::values[hashNum].getCurrentHPHash(_playerID, currentHP()); std::cout << hash << "\n";
-    hash ^= Hash::values[hashNum].getUnitTypeHash(_playerID, typeID()); std::cout << hash << "\n";
+    std::cout << calculateHash(hashNum) << " " << calculateTimeHash(hashNum) << "\n";
 }
 
 const std::string Unit::debugString() const
@@ -620,13 +634,12 @@ const std::string Unit::debugString() const
     ss << "Unit ID:             " << (int)ID()                                      << "\n";
     ss << "Player:              " << (int)player()                                  << "\n";
     ss << "Range:               " << range()                                        << "\n";
-    ss << "Position:            " << "(" << _position.x() << "," << _position.y()   << ")\n";
+    ss << "Position:            " << "(" << _x << "," << _y   << ")\n";
     ss << "Current HP:          " << currentHP()                                    << "\n";
     ss << "Next Move Time:      " << nextMoveActionTime()                           << "\n";
     ss << "Next Attack Time:    " << nextAttackActionTime()                         << "\n";
     ss << "Previous Action:     " << previousAction().debugString()                 << "\n";
-    ss << "Previous Pos Time:   " << _prevCurrentPosTime                            << "\n";
-    ss << "Previous Pos:        " << "(" << _prevCurrentPos.x() << "," << _prevCurrentPos.y()   << ")\n";
+    ss << "Previous Pos:        " << "(" << previousPosition().x() << "," << previousPosition().y()   << ")\n";
 
     return ss.str();
 }
\ No newline at end of file
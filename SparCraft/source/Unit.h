@@ -15,32 +15,35 @@ namespace SparCraft
 
 class UnitAction;
 
+// A unit is a plain record, 32 bytes with 8 bit IDs and 40 with the 16 bit IDs of capacities above 127,
+// which can be copied with memcpy, GameState relies on this.
+// Everything that follows from the unit type is looked up from the type ID, and the previous
+// action only keeps what the simulation needs: its type, its move index and for a MOVE its
+// destination, which is the unit's position
 class Unit 
 {
-    BWAPI::UnitType     _unitType;				// the BWAPI unit type that we are mimicing
-    PositionType        _range;
-	
-	Position            _position;				// current location in a possibly infinite space
-	
-	IDType              _unitID;				// unique unit ID to the state it's contained in
-    IDType              _playerID;				// the player who controls the unit
-	
-	HealthType          _currentHP;				// current HP of the unit
-	HealthType          _currentEnergy;
+	PositionType        _x;						// current location in a possibly infinite space, kept as plain
+	PositionType        _y;						// values since a Position member would be zeroed by Unit()
 
 	TimeType            _timeCanMove;			// time the unit can next move
 	TimeType            _timeCanAttack;			// time the unit can next attack
-
-	UnitAction          _previousAction;		// the previous action that the unit performed
 	TimeType            _previousActionTime;	// the time the previous move was performed
-	Position            _previousPosition;
 
-    mutable TimeType    _prevCurrentPosTime;
-    mutable Position    _prevCurrentPos;
+	HealthType          _currentHP;				// current HP of the unit
+	short               _previousDX;			// offset of the position before the last MOVE from the current one
+	short               _previousDY;
+
+	unsigned char       _typeID;				// ID of the BWAPI unit type that we are mimicing
+	IDType              _unitID;				// unique unit ID to the state it's contained in
+    IDType              _playerID;				// the player who controls the unit
+	unsigned char       _currentEnergy;			// at most 250 in broodwar
+	IDType              _previousActionType;	// type and move index of the previous action the unit performed
+	IDType              _previousActionIndex;
 
 public:
 
-	Unit();
+	// leaves the unit uninitialized so that arrays of units cost nothing to construct, see Empty()
+	Unit() {}
 	//Unit(BWAPI::Unit * unit, BWAPI::Game * game, const IDType & playerID, const TimeType & gameTime);
 	Unit(const BWAPI::UnitType unitType, const IDType & playerID, const Position & pos);
 	Unit(const BWAPI::UnitType unitType, const Position & pos, const IDType & unitID, const IDType & playerID, 
@@ -48,6 +51,9 @@ public:
 
 	const bool operator < (const Unit & rhs) const;
 
+	// the dead placeholder unit used for empty unit slots
+	static const Unit       Empty();
+
     // action functions
 	void                    setPreviousAction(const UnitAction & m, const TimeType & previousMoveTime);
 	void                    updateAttackActionTime(const TimeType & newTime);
@@ -79,16 +85,16 @@ public:
 	const IDType		    player()                    const;
 
     // position related functions
-	const Position &        position()                  const;
-	const Position &        pos()                       const;
+	const Position          position()                  const;
+	const Position          pos()                       const;
+	const Position          previousPosition()          const;
 	const PositionType      x()                         const;
 	const PositionType      y()                         const;
 	const PositionType      range()                     const;
 	const PositionType      healRange()                 const;
 	const PositionType      getDistanceSqToUnit(const Unit & u, const TimeType & gameTime) const;
 	const PositionType      getDistanceSqToPosition(const Position & p, const TimeType & gameTime) const;
-    const Position &        currentPosition(const TimeType & gameTime) const;
-    void                    setPreviousPosition(const TimeType & gameTime);
+    const Position          currentPosition(const TimeType & gameTime) const;
 
     // health and damage related functions
 	const HealthType        damage()                    const;
@@ -122,14 +128,15 @@ public:
 	const int			    typeID()                    const;
 	const double		    speed()                     const;
 	const BWAPI::UnitType   type()                      const;
-	const UnitAction &	    previousAction()            const;
+	const UnitAction 	    previousAction()            const;
 	const std::string       name()                      const;
 	void                    print()                     const;
     const std::string       debugString()               const;
 
-	// hash functions
-	const HashType          calculateHash(const size_t & hashNum, const TimeType & gameTime) const;
-	void                    debugHash(const size_t & hashNum, const TimeType & gameTime) const;
+	// hash functions, the GameState combines these into the state hash
+	const HashType          calculateHash(const size_t & hashNum) const;
+	const HashType          calculateTimeHash(const size_t & hashNum) const;
+	void                    debugHash(const size_t & hashNum) const;
 };
 
 class UnitPtrCompare
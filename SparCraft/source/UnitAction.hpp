@@ -24,10 +24,10 @@ public:
     Position        _p;
 
 	UnitAction()
-		: _unit(255)
-		, _player(255)
+		: _unit(Constants::No_ID)
+		, _player(Constants::No_ID)
 		, _moveType(UnitActionTypes::NONE)
-		, _moveIndex(255)
+		, _moveIndex(Constants::No_ID)
 	{
 
 	}
@@ -51,7 +51,7 @@ public:
 		
 	}
 
-	const bool operator == (const UnitAction & rhs)
+	const bool operator == (const UnitAction & rhs) const
 	{
 		return _unit == rhs._unit && _player == rhs._player && _moveType == rhs._moveType && _moveIndex == rhs._moveIndex && _p == rhs._p;
 	}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "Common.h"
+#include "Unit.h"
+#include "CombatTables.h"
+#include <cstring>
+
+namespace SparCraft
+{
+    class UnitArrays;
+}
+
+// Structure-of-arrays copy of the unit data which the GameState scans over most often.
+// Entries are indexed exactly like GameState::getUnit(player, unitIndex), positions are
+// the current positions at the state's game time. The GameState owns the Unit objects and
+// keeps these arrays in sync with them, nobody else should write to this class.
+// Copies only copy the entries which have been set, like the GameState's UnitSlots
+class SparCraft::UnitArrays
+{
+public:
+
+    enum { Alive = 1, MobileAttacker = 2, Attacker = 4, Flyer = 8, CanAttackGround = 16, CanAttackAir = 32, Healer = 64 };
+
+    // rows read by the target kernels are padded so they can be read 16 units at a time
+    enum { Padded_Units = (Constants::Max_Units + 15) / 16 * 16 };
+
+private:
+
+    PositionType        _x              [Constants::Num_Players][Padded_Units];
+    PositionType        _y              [Constants::Num_Players][Padded_Units];
+    HealthType          _hp             [Constants::Num_Players][Constants::Max_Units];
+    TimeType            _timeCanAttack  [Constants::Num_Players][Constants::Max_Units];
+    TimeType            _timeCanMove    [Constants::Num_Players][Constants::Max_Units];
+    float               _dpf            [Constants::Num_Players][Constants::Max_Units];
+    IDType              _unitID         [Constants::Num_Players][Constants::Max_Units];
+    unsigned char       _flags          [Constants::Num_Players][Padded_Units];
+    size_t              _numEntries     [Constants::Num_Players];
+
+    template <class T>
+    static void copyRow(T * dest, const T * src, const size_t & num)
+    {
+        memcpy(dest, src, num * sizeof(T));
+    }
+
+    void copy(const UnitArrays & rhs)
+    {
+        for (size_t p(0); p < Constants::Num_Players; ++p)
+        {
+            const size_t num(rhs._numEntries[p]);
+
+            // the padded rows are read 16 units at a time, so the whole block is copied
+            const size_t padded((num + 15) / 16 * 16);
+
+            _numEntries[p] = num;
+            copyRow(_x[p],              rhs._x[p],              padded);
+            copyRow(_y[p],              rhs._y[p],              padded);
+            copyRow(_flags[p],          rhs._flags[p],          padded);
+            copyRow(_hp[p],             rhs._hp[p],             num);
+            copyRow(_timeCanAttack[p],  rhs._timeCanAttack[p],  num);
+            copyRow(_timeCanMove[p],    rhs._timeCanMove[p],    num);
+            copyRow(_dpf[p],            rhs._dpf[p],            num);
+            copyRow(_unitID[p],         rhs._unitID[p],         num);
+        }
+    }
+
+public:
+
+    UnitArrays()
+    {
+        memset(this, 0, sizeof(UnitArrays));
+    }
+
+    UnitArrays(const UnitArrays & rhs)
+    {
+        copy(rhs);
+    }
+
+    UnitArrays & operator = (const UnitArrays & rhs)
+    {
+        if (this != &rhs)
+        {
+            copy(rhs);
+        }
+
+        return *this;
+    }
+
+    // copy every field of the given unit into slot [player][index]
+    void set(const IDType & player, const size_t & index, const Unit & unit, const TimeType & gameTime)
+    {
+        const Position & pos(unit.currentPosition(gameTime));
+        const int type(unit.typeID());
+
+        unsigned char flags(0);
+        flags |= unit.isAlive()                                 ? Alive             : 0;
+        flags |= (unit.isMobile() && !unit.canHeal())           ? MobileAttacker    : 0;
+        flags |= (unit.damage() > 0)                            ? Attacker          : 0;
+        flags |= CombatTables::getIsFlyer(type)                 ? Flyer             : 0;
+        flags |= CombatTables::getCanAttackGround(type)         ? CanAttackGround   : 0;
+        flags |= CombatTables::getCanAttackAir(type)            ? CanAttackAir      : 0;
+        flags |= unit.canHeal()                                 ? Healer            : 0;
+
+        _x[player][index]               = pos.x();
+        _y[player][index]               = pos.y();
+        _hp[player][index]              = unit.currentHP();
+        _timeCanAttack[player][index]   = unit.nextAttackActionTime();
+        _timeCanMove[player][index]     = unit.nextMoveActionTime();
+        _dpf[player][index]             = unit.dpf();
+        _unitID[player][index]          = unit.ID();
+        _flags[player][index]           = flags;
+        _numEntries[player]             = std::max(_numEntries[player], index + 1);
+    }
+
+    // update only the fields that performing an action can change
+    void update(const IDType & player, const size_t & index, const Unit & unit)
+    {
+        _hp[player][index]              = unit.currentHP();
+        _timeCanAttack[player][index]   = unit.nextAttackActionTime();
+        _timeCanMove[player][index]     = unit.nextMoveActionTime();
+
+        if (unit.isAlive())
+        {
+            _flags[player][index] |= Alive;
+        }
+        else
+        {
+            _flags[player][index] &= ~Alive;
+        }
+    }
+
+    const PositionType      x(const IDType & player, const size_t & index)              const   { return _x[player][index]; }
+    const PositionType      y(const IDType & player, const size_t & index)              const   { return _y[player][index]; }
+    const HealthType        hp(const IDType & player, const size_t & index)             const   { return _hp[player][index]; }
+    const float             dpf(const IDType & player, const size_t & index)            const   { return _dpf[player][index]; }
+    const IDType            ID(const IDType & player, const size_t & index)             const   { return _unitID[player][index]; }
+    const bool              is(const IDType & player, const size_t & index, const int & flag) const { return (_flags[player][index] & flag) != 0; }
+
+    const TimeType          firstTimeFree(const IDType & player, const size_t & index)  const
+    {
+        return _timeCanAttack[player][index] <= _timeCanMove[player][index] ? _timeCanAttack[player][index] : _timeCanMove[player][index];
+    }
+
+    const PositionType      distSq(const IDType & player, const size_t & index, const PositionType & x, const PositionType & y) const
+    {
+        const PositionType dx(_x[player][index] - x);
+        const PositionType dy(_y[player][index] - y);
+
+        return dx*dx + dy*dy;
+    }
+
+    // whether an attacker of the given flags could hit the unit at [player][index] with a weapon
+    const bool              weaponCanTarget(const unsigned char & attackerFlags, const IDType & player, const size_t & index) const
+    {
+        return (attackerFlags & ((_flags[player][index] & Flyer) ? CanAttackAir : CanAttackGround)) != 0;
+    }
+
+    const unsigned char     flags(const IDType & player, const size_t & index)          const   { return _flags[player][index]; }
+
+    // contiguous rows of a player's units for the target kernels
+    const PositionType *    xRow(const IDType & player)                                 const   { return _x[player]; }
+    const PositionType *    yRow(const IDType & player)                                 const   { return _y[player]; }
+    const unsigned char *   flagsRow(const IDType & player)                             const   { return _flags[player]; }
+};
@@ -0,0 +1,361 @@
+#include "UnitGrid.h"
+#include <cstring>
+
+using namespace SparCraft;
+
+UnitGrid::UnitGrid()
+    : _enabled(false)
+    , _cellSize(Constants::Unit_Grid_Cell_Tiles * TILE_SIZE)
+    , _width(Constants::Unit_Grid_Max_Cells)
+    , _height(Constants::Unit_Grid_Max_Cells)
+    , _slack(0)
+{
+    _numSlots[0] = _numSlots[1] = 0;
+}
+
+UnitGrid::UnitGrid(const UnitGrid & rhs)
+{
+    copy(rhs);
+}
+
+UnitGrid & UnitGrid::operator = (const UnitGrid & rhs)
+{
+    if (this != &rhs)
+    {
+        copy(rhs);
+    }
+
+    return *this;
+}
+
+// a disabled grid has nothing in it, otherwise only the cells covering the map and the used slots are copied
+void UnitGrid::copy(const UnitGrid & rhs)
+{
+    _enabled    = rhs._enabled;
+    _cellSize   = rhs._cellSize;
+    _width      = rhs._width;
+    _height     = rhs._height;
+    _slack      = rhs._slack;
+
+    for (IDType p(0); p < Constants::Num_Players; ++p)
+    {
+        _numSlots[p]    = rhs._numSlots[p];
+        _minX[p]        = rhs._minX[p];
+        _maxX[p]        = rhs._maxX[p];
+        _minY[p]        = rhs._minY[p];
+        _maxY[p]        = rhs._maxY[p];
+
+        if (_enabled)
+        {
+            memcpy(_head[p],    rhs._head[p],   _width * _height * sizeof(IDType));
+            memcpy(_next[p],    rhs._next[p],   _numSlots[p] * sizeof(IDType));
+            memcpy(_cell[p],    rhs._cell[p],   _numSlots[p] * sizeof(short));
+            memcpy(_index[p],   rhs._index[p],  _numSlots[p] * sizeof(IDType));
+        }
+    }
+}
+
+void UnitGrid::reset(const Map * map)
+{
+    int cellTiles(Constants::Unit_Grid_Cell_Tiles);
+    int tileWidth(Constants::Unit_Grid_Max_Cells * cellTiles);
+    int tileHeight(Constants::Unit_Grid_Max_Cells * cellTiles);
+
+    // large maps get larger cells so the grid never has more than the max number of cells
+    if (map)
+    {
+        tileWidth  = std::max((int)map->getBuildTileWidth(), 1);
+        tileHeight = std::max((int)map->getBuildTileHeight(), 1);
+
+        const int maxCells(Constants::Unit_Grid_Max_Cells);
+        cellTiles = std::max(cellTiles, (std::max(tileWidth, tileHeight) + maxCells - 1) / maxCells);
+    }
+
+    _enabled    = true;
+    _cellSize   = cellTiles * TILE_SIZE;
+    _width      = (tileWidth + cellTiles - 1) / cellTiles;
+    _height     = (tileHeight + cellTiles - 1) / cellTiles;
+    _slack      = 0;
+    _numSlots[0] = _numSlots[1] = 0;
+
+    std::fill(&_head[0][0], &_head[0][0] + Constants::Num_Players * Max_Cells, (IDType)None);
+    std::fill(&_cell[0][0], &_cell[0][0] + Constants::Num_Players * Constants::Max_Units, (short)-1);
+
+    for (IDType p(0); p < Constants::Num_Players; ++p)
+    {
+        _minX[p] = _width;
+        _minY[p] = _height;
+        _maxX[p] = -1;
+        _maxY[p] = -1;
+    }
+}
+
+const bool UnitGrid::isEnabled() const
+{
+    return _enabled;
+}
+
+// positions outside of the map are clamped to the border cells
+const int UnitGrid::cellX(const PositionType & x) const
+{
+    return x <= 0 ? 0 : std::min((int)(x / _cellSize), _width - 1);
+}
+
+const int UnitGrid::cellY(const PositionType & y) const
+{
+    return y <= 0 ? 0 : std::min((int)(y / _cellSize), _height - 1);
+}
+
+const int UnitGrid::cellOf(const Position & pos) const
+{
+    return cellY(pos.y()) * _width + cellX(pos.x());
+}
+
+// a unit which is moving is somewhere between its previous position and pos()
+void UnitGrid::updateSlack(const Unit & unit)
+{
+    if (unit.previousAction().type() == UnitActionTypes::MOVE)
+    {
+        const PositionType dist(abs(unit.pos().x() - unit.previousPosition().x()) + abs(unit.pos().y() - unit.previousPosition().y()) + 1);
+
+        _slack = std::max(_slack, dist);
+    }
+}
+
+void UnitGrid::insert(const IDType & player, const size_t & slot, const Unit & unit)
+{
+    const int cell(cellOf(unit.pos()));
+
+    _next[player][slot] = _head[player][cell];
+    _head[player][cell] = (IDType)slot;
+    _cell[player][slot] = (short)cell;
+    _numSlots[player]   = std::max(_numSlots[player], slot + 1);
+
+    // the occupied area only grows until the grid is reset
+    _minX[player] = std::min(_minX[player], cell % _width);
+    _maxX[player] = std::max(_maxX[player], cell % _width);
+    _minY[player] = std::min(_minY[player], cell / _width);
+    _maxY[player] = std::max(_maxY[player], cell / _width);
+
+    updateSlack(unit);
+}
+
+void UnitGrid::remove(const IDType & player, const size_t & slot)
+{
+    const int cell(_cell[player][slot]);
+
+    if (cell < 0)
+    {
+        return;
+    }
+
+    IDType * link(&_head[player][cell]);
+
+    while (*link != slot)
+    {
+        link = &_next[player][*link];
+    }
+
+    *link = _next[player][slot];
+    _cell[player][slot] = -1;
+}
+
+void UnitGrid::move(const IDType & player, const size_t & slot, const Unit & unit)
+{
+    if (_cell[player][slot] != cellOf(unit.pos()))
+    {
+        remove(player, slot);
+        insert(player, slot, unit);
+    }
+    else
+    {
+        updateSlack(unit);
+    }
+}
+
+void UnitGrid::setUnitIndex(const IDType & player, const size_t & slot, const size_t & unitIndex)
+{
+    _index[player][slot] = (IDType)unitIndex;
+    _numSlots[player]    = std::max(_numSlots[player], slot + 1);
+}
+
+// number of rings around the given cell needed to cover every occupied cell of the player
+const int UnitGrid::maxRing(const IDType & player, const int & cx, const int & cy) const
+{
+    return std::max(std::max(cx - _minX[player], _maxX[player] - cx), std::max(cy - _minY[player], _maxY[player] - cy));
+}
+
+// writes the cells of the square ring r around the given cell which can hold units of the player
+const int UnitGrid::ringCells(const IDType & player, const int & cx, const int & cy, const int & r, int * cells) const
+{
+    const int minX(std::max(cx - r, _minX[player]));
+    const int maxX(std::min(cx + r, _maxX[player]));
+    const int minY(std::max(cy - r, _minY[player]));
+    const int maxY(std::min(cy + r, _maxY[player]));
+
+    int numCells(0);
+
+    for (int gy(minY); gy <= maxY; ++gy)
+    {
+        // only the top and bottom rows of the ring are full, the others just have their two end cells
+        if (gy == cy - r || gy == cy + r)
+        {
+            for (int gx(minX); gx <= maxX; ++gx)
+            {
+                cells[numCells++] = gy * _width + gx;
+            }
+        }
+        else
+        {
+            if (cx - r >= minX)
+            {
+                cells[numCells++] = gy * _width + cx - r;
+            }
+
+            if (r > 0 && cx + r <= maxX)
+            {
+                cells[numCells++] = gy * _width + cx + r;
+            }
+        }
+    }
+
+    return numCells;
+}
+
+// Every cell in ring r around the query cell is at least r-1 whole cells away from the query point,
+// so once that distance minus the slack is past the best distance found the search can stop.
+// Clamping positions to the border cells keeps this true for units outside of the map
+const int UnitGrid::closest(const UnitArrays & arrays, const IDType & player, const PositionType & x, const PositionType & y,
+                            const PositionType & maxDistSq, const int & maxTie, const bool tieOnID,
+                            const int & skipIndex, const int & skipFlags) const
+{
+    int             bestIndex(-1);
+    PositionType    bestDistSq(maxDistSq);
+    int             bestTie(maxTie);
+
+    const int cx(cellX(x));
+    const int cy(cellY(y));
+
+    int cells[8 * Constants::Unit_Grid_Max_Cells];
+
+    for (int r(0); r <= maxRing(player, cx, cy); ++r)
+    {
+        const PositionType bound((r - 1) * _cellSize - _slack);
+
+        if (bound > 0 && bound * bound >= bestDistSq)
+        {
+            break;
+        }
+
+        const int numCells(ringCells(player, cx, cy, r, cells));
+
+        for (int c(0); c < numCells; ++c)
+        {
+            for (IDType slot(_head[player][cells[c]]); slot != None; slot = _next[player][slot])
+            {
+                const int u(_index[player][slot]);
+
+                if (u == skipIndex || (skipFlags && arrays.is(player, u, skipFlags)))
+                {
+                    continue;
+                }
+
+                const PositionType  distSq(arrays.distSq(player, u, x, y));
+                const int           tie(tieOnID ? arrays.ID(player, u) : u);
+
+                if (distSq < bestDistSq || (distSq == bestDistSq && tie < bestTie))
+                {
+                    bestIndex   = u;
+                    bestDistSq  = distSq;
+                    bestTie     = tie;
+                }
+            }
+        }
+    }
+
+    return bestIndex;
+}
+
+const size_t UnitGrid::closestK(const UnitArrays & arrays, const IDType & player, const PositionType & x, const PositionType & y,
+                                const size_t & k, IDType * unitIndices) const
+{
+    if (k == 0)
+    {
+        return 0;
+    }
+
+    PositionType    distSq[Constants::Max_Units];
+    size_t          found(0);
+
+    const int cx(cellX(x));
+    const int cy(cellY(y));
+
+    int cells[8 * Constants::Unit_Grid_Max_Cells];
+
+    for (int r(0); r <= maxRing(player, cx, cy); ++r)
+    {
+        const PositionType bound((r - 1) * _cellSize - _slack);
+
+        if (found == k && bound > 0 && bound * bound >= distSq[k-1])
+        {
+            break;
+        }
+
+        const int numCells(ringCells(player, cx, cy, r, cells));
+
+        for (int c(0); c < numCells; ++c)
+        {
+            for (IDType slot(_head[player][cells[c]]); slot != None; slot = _next[player][slot])
+            {
+                const IDType        u(_index[player][slot]);
+                const PositionType  d(arrays.distSq(player, u, x, y));
+
+                // insertion into the sorted list of the best k so far
+                size_t i(found < k ? found++ : k);
+                for (; i > 0 && (d < distSq[i-1] || (d == distSq[i-1] && arrays.ID(player, u) < arrays.ID(player, unitIndices[i-1]))); --i)
+                {
+                    if (i < k)
+                    {
+                        distSq[i]      = distSq[i-1];
+                        unitIndices[i] = unitIndices[i-1];
+                    }
+                }
+
+                if (i < k)
+                {
+                    distSq[i]      = d;
+                    unitIndices[i] = u;
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+const size_t UnitGrid::inRange(const UnitArrays & arrays, const IDType & player, const PositionType & x, const PositionType & y,
+                               const PositionType & rangeSq, IDType * unitIndices) const
+{
+    const PositionType reach((PositionType)sqrt((double)rangeSq) + 1 + _slack);
+    size_t found(0);
+
+    for (int gy(std::max(cellY(y - reach), _minY[player])); gy <= std::min(cellY(y + reach), _maxY[player]); ++gy)
+    {
+        for (int gx(std::max(cellX(x - reach), _minX[player])); gx <= std::min(cellX(x + reach), _maxX[player]); ++gx)
+        {
+            for (IDType slot(_head[player][gy * _width + gx]); slot != None; slot = _next[player][slot])
+            {
+                const IDType u(_index[player][slot]);
+
+                if (arrays.distSq(player, u, x, y) <= rangeSq)
+                {
+                    unitIndices[found++] = u;
+                }
+            }
+        }
+    }
+
+    std::sort(unitIndices, unitIndices + found);
+
+    return found;
+}
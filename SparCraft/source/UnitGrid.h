@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Common.h"
+#include "Map.hpp"
+#include "Unit.h"
+#include "UnitArrays.hpp"
+
+namespace SparCraft
+{
+    class UnitGrid;
+}
+
+// Uniform grid laid over the map's build tiles which buckets the living units of each player by
+// position, so closest unit and range queries only have to look at the cells around a point.
+// Units are bucketed by their destination pos(), while queries measure the current positions
+// stored in the UnitArrays. A unit still moving is at most _slack pixels away from its bucket.
+// Units are stored by their slot in the GameState unit array, which never changes, and queries
+// return the sorted unit indices used by GameState::getUnit(player, unitIndex).
+// Copies only copy the cells of the map and the slots which have been used
+class SparCraft::UnitGrid
+{
+    enum { None = Constants::No_ID, Max_Cells = Constants::Unit_Grid_Max_Cells * Constants::Unit_Grid_Max_Cells };
+
+    bool                _enabled;
+    PositionType        _cellSize;
+    int                 _width;
+    int                 _height;
+    PositionType        _slack;
+    size_t              _numSlots[Constants::Num_Players];                      // slots which have been used since the last reset
+
+    IDType              _head   [Constants::Num_Players][Max_Cells];            // first unit slot in each cell
+    IDType              _next   [Constants::Num_Players][Constants::Max_Units]; // next unit slot in the same cell
+    short               _cell   [Constants::Num_Players][Constants::Max_Units]; // cell of each unit slot, -1 if none
+    IDType              _index  [Constants::Num_Players][Constants::Max_Units]; // sorted unit index of each slot
+
+    // bounding box of the cells each player has ever had a unit in since the last reset
+    int                 _minX   [Constants::Num_Players];
+    int                 _maxX   [Constants::Num_Players];
+    int                 _minY   [Constants::Num_Players];
+    int                 _maxY   [Constants::Num_Players];
+
+    const int           cellX(const PositionType & x)                                                   const;
+    const int           cellY(const PositionType & y)                                                   const;
+    const int           cellOf(const Position & pos)                                                    const;
+    void                updateSlack(const Unit & unit);
+    const int           maxRing(const IDType & player, const int & cx, const int & cy)                  const;
+    const int           ringCells(const IDType & player, const int & cx, const int & cy, const int & r, int * cells) const;
+    void                copy(const UnitGrid & rhs);
+
+public:
+
+    UnitGrid();
+    UnitGrid(const UnitGrid & rhs);
+    UnitGrid &          operator = (const UnitGrid & rhs);
+
+    // clears the grid and sizes it to the map, or to a default area if there is no map
+    void                reset(const Map * map);
+    const bool          isEnabled()                                                                     const;
+
+    void                insert(const IDType & player, const size_t & slot, const Unit & unit);
+    void                remove(const IDType & player, const size_t & slot);
+    void                move(const IDType & player, const size_t & slot, const Unit & unit);
+    void                setUnitIndex(const IDType & player, const size_t & slot, const size_t & unitIndex);
+
+    // index of the unit with the smallest (distSq, tie) which is also smaller than (maxDistSq, maxTie),
+    // tie is the unit ID if tieOnID is set and the unit index otherwise. returns -1 if there is none
+    const int           closest(const UnitArrays & arrays, const IDType & player, const PositionType & x, const PositionType & y,
+                                const PositionType & maxDistSq, const int & maxTie, const bool tieOnID,
+                                const int & skipIndex, const int & skipFlags)                           const;
+
+    // the k closest units ordered by (distSq, unit ID), returns how many were written
+    const size_t        closestK(const UnitArrays & arrays, const IDType & player, const PositionType & x, const PositionType & y,
+                                 const size_t & k, IDType * unitIndices)                                const;
+
+    // all units within sqrt(rangeSq) ordered by unit index, returns how many were written
+    const size_t        inRange(const UnitArrays & arrays, const IDType & player, const PositionType & x, const PositionType & y,
+                                const PositionType & rangeSq, IDType * unitIndices)                     const;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Common.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace SparCraft
+{
+    class UnitMask;
+}
+
+// Bit set over the unit indices of one player, used to pass sets of target units around
+// without building vectors. Iterate it in index order with:
+//   for (size_t u(mask.next(0)); u < Constants::Max_Units; u = mask.next(u+1))
+class SparCraft::UnitMask
+{
+public:
+
+    enum { Num_Words = (Constants::Max_Units + 31) / 32 };
+
+private:
+
+    unsigned int        _bits[Num_Words];
+
+    static const size_t lowestBit(const unsigned int & word)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, word);
+        return index;
+#else
+        return __builtin_ctz(word);
+#endif
+    }
+
+public:
+
+    UnitMask()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for (size_t w(0); w < Num_Words; ++w)
+        {
+            _bits[w] = 0;
+        }
+    }
+
+    void set(const size_t & index)
+    {
+        _bits[index / 32] |= 1u << (index % 32);
+    }
+
+    void reset(const size_t & index)
+    {
+        _bits[index / 32] &= ~(1u << (index % 32));
+    }
+
+    const bool contains(const size_t & index) const
+    {
+        return (_bits[index / 32] & (1u << (index % 32))) != 0;
+    }
+
+    const bool isEmpty() const
+    {
+        for (size_t w(0); w < Num_Words; ++w)
+        {
+            if (_bits[w])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    const size_t count() const
+    {
+        size_t num(0);
+
+        for (size_t w(0); w < Num_Words; ++w)
+        {
+            for (unsigned int bits(_bits[w]); bits; bits &= bits - 1)
+            {
+                ++num;
+            }
+        }
+
+        return num;
+    }
+
+    // the first index >= index which is in the set, Constants::Max_Units if there is none
+    const size_t next(const size_t & index) const
+    {
+        size_t w(index / 32);
+
+        if (w >= Num_Words)
+        {
+            return Constants::Max_Units;
+        }
+
+        unsigned int bits(_bits[w] & (~0u << (index % 32)));
+
+        while (!bits)
+        {
+            if (++w == Num_Words)
+            {
+                return Constants::Max_Units;
+            }
+
+            bits = _bits[w];
+        }
+
+        return w * 32 + lowestBit(bits);
+    }
+
+    // direct access to 32 indices at a time for the target kernels
+    unsigned int &          word(const size_t & w)          { return _bits[w]; }
+    const unsigned int &    word(const size_t & w)  const   { return _bits[w]; }
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Common.h"
+#include "Unit.h"
+#include <cstring>
+
+namespace SparCraft
+{
+    class UnitSlots;
+}
+
+// The unit array of a GameState together with its sort order. A player's units live in the
+// first numSlots(player) slots, and unitIndex(player)[u] is the slot of the unit with sorted
+// index u. Copying only has to memcpy the used slots and their order, which makes the cost of
+// copying a GameState depend on the units in the battle rather than on Constants::Max_Units.
+// Slots of dead units are reused by the next unit added. Slot 0 is always copied so that it
+// holds a valid unit
+class SparCraft::UnitSlots
+{
+    UnitCountType   _numSlots[Constants::Num_Players];
+    int             _unitIndex[Constants::Num_Players][Constants::Max_Units];
+    Unit            _units[Constants::Num_Players][Constants::Max_Units];
+
+    void copy(const UnitSlots & rhs)
+    {
+        for (size_t p(0); p < Constants::Num_Players; ++p)
+        {
+            _numSlots[p] = rhs._numSlots[p];
+            memcpy(_unitIndex[p], rhs._unitIndex[p], _numSlots[p] * sizeof(int));
+            memcpy(_units[p], rhs._units[p], std::max((size_t)_numSlots[p], (size_t)1) * sizeof(Unit));
+        }
+    }
+
+public:
+
+    UnitSlots()
+    {
+        for (size_t p(0); p < Constants::Num_Players; ++p)
+        {
+            _numSlots[p] = 0;
+            std::fill(_units[p], _units[p] + Constants::Max_Units, Unit::Empty());
+        }
+    }
+
+    UnitSlots(const UnitSlots & rhs)
+    {
+        copy(rhs);
+    }
+
+    UnitSlots & operator = (const UnitSlots & rhs)
+    {
+        if (this != &rhs)
+        {
+            copy(rhs);
+        }
+
+        return *this;
+    }
+
+    // the slot to write a new unit to which will get the given sorted index, which has to be the
+    // player's number of living units. This is the slot of a dead unit if there is one
+    const int add(const IDType & player, const size_t & unitIndex)
+    {
+        if (unitIndex == _numSlots[player])
+        {
+            _unitIndex[player][unitIndex] = (int)unitIndex;
+            _numSlots[player]++;
+        }
+
+        return _unitIndex[player][unitIndex];
+    }
+
+    const size_t numSlots(const IDType & player) const
+    {
+        return _numSlots[player];
+    }
+
+    // the unit with the given sorted index
+    Unit &          get(const IDType & player, const size_t & unitIndex)                { return _units[player][_unitIndex[player][unitIndex]]; }
+    const Unit &    get(const IDType & player, const size_t & unitIndex)        const   { return _units[player][_unitIndex[player][unitIndex]]; }
+
+    // slot of the unit with the given sorted index, the GameState sorts these rows directly
+    const int       slot(const IDType & player, const size_t & unitIndex)       const   { return _unitIndex[player][unitIndex]; }
+    int *           unitIndex(const IDType & player)                                    { return _unitIndex[player]; }
+
+    // the unit in the given slot
+    Unit *          operator [] (const IDType & player)                                 { return _units[player]; }
+    const Unit *    operator [] (const IDType & player)                         const   { return _units[player]; }
+};
@@ -9,6 +9,7 @@
 #include "StarcraftSearchConstraint.hpp"
 #include "SearchParameters.hpp"
 #include "TranspositionTable.hpp"
+#include "SearchDeadline.hpp"
 
 namespace BuildOrderSearch
 {
@@ -33,6 +34,8 @@ class DFBBStarcraftSearch : public StarcraftSearch
 	
 	bool finishedLoadingSaveState;
 	
+	SearchDeadline deadline;							// the time limit, polled once per node
+	
 	//TranspositionTable<unsigned int, int>   TT;
 	int ttcuts;
 	
@@ -73,26 +76,13 @@ public:
 	virtual SearchResults search()
 	{
 		searchTimer.start();
+		deadline.start(params.searchTimeLimit);
 
-		// try to search since we throw exception on timeout
-		try {
-		
-			// search on the initial state
-			DFBB(params.initialState, 0);
-
-			results.timedOut = false;
-		
-		// if we catch a timeout exception
-		} catch (int e) {
-		
-			//printf("Search timed out at %dms\n", params.searchTimeLimit);
-		
-			// store that we timed out in the results
-			results.timedOut = true;
+		// search on the initial state, which returns early if the search times out
+		DFBB(params.initialState, 0);
 
-			// for some reason MSVC++ complains about e being unused, so use it
-			e = e + 1;
-		}
+		// store whether we timed out in the results, the best solution so far is in them already
+		results.timedOut = deadline.isCancelled();
 		
 		// set the results
 		results.nodesExpanded = nodesExpanded;
@@ -101,6 +91,12 @@ public:
 		return results;
 	}
 	
+	// stops a running search, which then returns the best solution found so far
+	void cancel()
+	{
+		deadline.cancel();
+	}
+	
 	// recursive function which does all search logic
 	void DFBB(StarcraftState & s, int depth)
 	{		
@@ -162,15 +158,15 @@ public:
 			}
 		}
 		
-		// if we are using search timeout and we are over the limit
-		// (nodesExpanded % 1000 == 0) only checks the time every 1000 expansions, since it is slow
-		if (params.searchTimeLimit && (nodesExpanded % 200 == 0) && (searchTimer.getElapsedTimeInMilliSec() > params.searchTimeLimit))
+		// if we are using search timeout and we are over the limit, the deadline only reads the clock
+		// every so many nodes since it is slow
+		if (deadline.expired())
 		{
 			results.saveState = SearchSaveState(getBuildOrder(s), upperBound);
 			//results.saveState.print();
 		
-			// throw an exception to unroll the recursion
-			throw 1;
+			// return, and every node above returns once its child does
+			return;
 		}
 		
 		// get the legal action set
@@ -347,6 +343,11 @@ public:
 		for (size_t i(0); i<childStates.size(); ++i)
 		{
 		    DFBB(childStates[i], depth+1);
+
+		    if (deadline.isCancelled())
+		    {
+		        return;
+		    }
 		}
 	}
 	
@@ -0,0 +1,98 @@
+//
+// SearchDeadline.hpp
+//
+// The time limit of a search and a flag which cancels it, polled once per node.
+//
+// Reading the clock is slow compared to expanding a node, so it is only read every few polls.
+// How many is recalibrated from the node rate measured at each read, so that the clock is read
+// about every 1/Check_Fraction of the time limit, or right at the deadline if that comes first.
+// Once the time is up or cancel() has been called, which may be done from another thread, every
+// poll returns true and the search returns up the recursion on its own.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <boost/atomic.hpp>
+#include "Timer.hpp"
+
+namespace BuildOrderSearch
+{
+class SearchDeadline
+{
+	enum { Check_Fraction = 100, First_Interval = 16, Max_Interval = 1 << 16 };
+
+	Timer					timer;
+	double					limitMS;		// 0 means there is no time limit
+	boost::atomic<bool>		cancelled;
+	size_t					polls;			// polls since the clock was last read
+	size_t					interval;		// polls between reads of the clock
+	double					lastReadMS;
+
+	SearchDeadline(const SearchDeadline & rhs);
+	SearchDeadline & operator = (const SearchDeadline & rhs);
+
+public:
+
+	SearchDeadline()
+		: limitMS(0)
+		, cancelled(false)
+		, polls(0)
+		, interval(First_Interval)
+		, lastReadMS(0)
+	{
+	}
+
+	// starts the clock of a new search, which also clears a cancellation
+	void start(double limit)
+	{
+		limitMS = limit;
+		polls = 0;
+		interval = First_Interval;
+		lastReadMS = 0;
+		cancelled.store(false, boost::memory_order_relaxed);
+		timer.start();
+	}
+
+	void cancel()
+	{
+		cancelled.store(true, boost::memory_order_relaxed);
+	}
+
+	bool isCancelled() const
+	{
+		return cancelled.load(boost::memory_order_relaxed);
+	}
+
+	// true once the search should stop
+	bool expired()
+	{
+		if (isCancelled())
+		{
+			return true;
+		}
+
+		if (limitMS <= 0 || ++polls < interval)
+		{
+			return false;
+		}
+
+		double ms = timer.getElapsedTimeInMilliSec();
+
+		if (ms >= limitMS)
+		{
+			cancel();
+			return true;
+		}
+
+		double msPerPoll = std::max(ms - lastReadMS, 0.0001) / polls;
+		double nextReadMS = std::min(limitMS / Check_Fraction, limitMS - ms);
+
+		interval = std::max((size_t)1, std::min((size_t)Max_Interval, (size_t)(nextReadMS / msPerPoll)));
+		polls = 0;
+		lastReadMS = ms;
+
+		return false;
+	}
+};
+}
@@ -101,9 +101,9 @@ public:
 	
 	//      Search time limit measured in milliseconds
 	//      If searchTimeLimit is set to a value greater than zero, the search will effectively
-	//          time out and the best solution so far will be used in the results. This is
-	//          accomplished by throwing an exception if the time limit is hit. Time is checked
-	//          once every 1000 nodes expanded, as checking the time is slow.
+	//          time out and the best solution so far will be used in the results. The search
+	//          returns up the recursion once the time limit is hit. Checking the time is slow,
+	//          so how often it is checked is adapted to the node rate, see SearchDeadline.hpp
 	int		searchTimeLimit;
 	
 	//      Initial upper bound for the DFBB search